@@ -0,0 +1,127 @@
+// Compares the table-driven hex dump with the original per-byte iostream
+// formatter. Both render into memory so terminal speed does not dominate.
+
+#include "pipetool/logging.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto kRunTime = std::chrono::milliseconds(500);
+
+// The formatter log_message used before the table-driven renderer.
+void legacy_hex_dump(std::wostream& out, std::span<const std::byte> payload) {
+    constexpr std::size_t kRowWidth = 16;
+    const std::size_t size = payload.size();
+
+    for (std::size_t offset = 0; offset < size; offset += kRowWidth) {
+        out << L"    " << std::setw(6) << std::setfill(L'0') << std::hex << offset << L"  ";
+
+        out << std::dec << std::setfill(L' ');
+        for (std::size_t column = 0; column < kRowWidth; ++column) {
+            const std::size_t index = offset + column;
+            if (index < size) {
+                const auto byte_value = static_cast<unsigned char>(payload[index]);
+                out << std::setw(2) << std::setfill(L'0') << std::hex << static_cast<unsigned int>(byte_value) << L' ';
+                out << std::dec;
+            } else {
+                out << L"   ";
+            }
+        }
+
+        out << L" |";
+        for (std::size_t column = 0; column < kRowWidth; ++column) {
+            const std::size_t index = offset + column;
+            if (index < size) {
+                const auto byte_value = static_cast<unsigned char>(payload[index]);
+                const bool printable = byte_value >= 32 && byte_value <= 126;
+                out << (printable ? static_cast<wchar_t>(byte_value) : L'.');
+            } else {
+                out << L' ';
+            }
+        }
+        out << L"|\n";
+    }
+
+    if (size == 0) {
+        out << L"    <empty>\n";
+    }
+
+    out << std::dec << std::setfill(L' ');
+}
+
+struct Result {
+    double input_bytes_per_second;
+    double output_bytes_per_second;
+};
+
+template <typename Render>
+Result measure(std::span<const std::byte> payload, Render&& render) {
+    std::size_t iterations = 0;
+    std::size_t output_chars = 0;
+    const auto start = Clock::now();
+    auto now = start;
+    while (now - start < kRunTime) {
+        output_chars += render(payload);
+        ++iterations;
+        now = Clock::now();
+    }
+    const double seconds = std::chrono::duration<double>(now - start).count();
+    return {
+        static_cast<double>(payload.size() * iterations) / seconds,
+        static_cast<double>(output_chars * sizeof(wchar_t)) / seconds};
+}
+
+} // namespace
+
+int main() {
+    std::vector<std::byte> payload(1024 * 1024);
+    for (std::size_t index = 0; index < payload.size(); ++index) {
+        payload[index] = static_cast<std::byte>((index * 7919u) >> 3);
+    }
+
+    std::wstring table_output;
+    std::wostringstream legacy_stream;
+
+    // Sanity check: both formatters must produce identical text.
+    pipetool::logging::format_hex_dump(std::span<const std::byte>(payload.data(), 1000), table_output);
+    legacy_hex_dump(legacy_stream, std::span<const std::byte>(payload.data(), 1000));
+    if (table_output != legacy_stream.str()) {
+        std::wcerr << L"hex dump output mismatch\n";
+        return 1;
+    }
+
+    std::wcout << std::setw(10) << L"payload" << std::setw(16) << L"legacy GB/s" << std::setw(16) << L"table GB/s"
+               << std::setw(10) << L"speedup" << L"   (GB/s of dump output)\n";
+
+    for (const std::size_t size : {16u, 256u, 4096u, 65536u, 1048576u}) {
+        const std::span<const std::byte> input(payload.data(), size);
+
+        const Result legacy = measure(input, [&legacy_stream](std::span<const std::byte> data) {
+            legacy_stream.str(std::wstring {});
+            legacy_hex_dump(legacy_stream, data);
+            return static_cast<std::size_t>(legacy_stream.tellp());
+        });
+        const Result table = measure(input, [&table_output](std::span<const std::byte> data) {
+            pipetool::logging::format_hex_dump(data, table_output);
+            return table_output.size();
+        });
+
+        constexpr double kGiga = 1024.0 * 1024.0 * 1024.0;
+        std::wcout << std::fixed << std::setprecision(3) << std::setw(10) << size
+                   << std::setw(16) << legacy.output_bytes_per_second / kGiga
+                   << std::setw(16) << table.output_bytes_per_second / kGiga
+                   << std::setprecision(1) << std::setw(9) << table.output_bytes_per_second / legacy.output_bytes_per_second << L"x\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Simulates --info over many pipes whose DACLs name the same few SIDs, with a
+// stub lookup that sleeps like a slow LookupAccountSidW. Compares serial and
+// parallel queries with and without SidNameCache, then checks that a saved
+// cache loads back.
+
+#include "pipetool/parallel.hpp"
+#include "pipetool/sid_cache.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kPipes = 200;
+constexpr std::size_t kSidsPerPipe = 5;
+constexpr std::size_t kDistinctSids = 12;
+constexpr auto kLookupTime = std::chrono::milliseconds(2);
+
+std::wstring sid_for(std::size_t pipe, std::size_t ace) {
+    return L"S-1-5-21-" + std::to_wstring((pipe * 7 + ace * 3) % kDistinctSids);
+}
+
+std::atomic<std::size_t> lookups {0};
+
+std::optional<std::wstring> slow_lookup(const std::wstring& sid) {
+    ++lookups;
+    std::this_thread::sleep_for(kLookupTime);
+    return L"DOMAIN\\account" + sid.substr(sid.rfind(L'-') + 1);
+}
+
+void run(const wchar_t* label, std::size_t jobs, pipetool::SidNameCache* cache) {
+    lookups = 0;
+    const auto start = Clock::now();
+    pipetool::run_parallel(kPipes, jobs, [cache](std::size_t pipe) {
+        for (std::size_t ace = 0; ace < kSidsPerPipe; ++ace) {
+            const std::wstring sid = sid_for(pipe, ace);
+            if (cache) {
+                cache->resolve(sid, [&sid] { return slow_lookup(sid); });
+            } else {
+                slow_lookup(sid);
+            }
+        }
+    });
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::wcout << std::setw(24) << label << std::setw(6) << jobs << std::fixed << std::setprecision(1)
+               << std::setw(12) << ms << std::setw(10) << lookups.load() << L"\n";
+}
+
+} // namespace
+
+int main() {
+    std::wcout << std::setw(24) << L"" << std::setw(6) << L"jobs" << std::setw(12) << L"ms" << std::setw(10) << L"lookups" << L"\n";
+    run(L"uncached", 1, nullptr);
+    run(L"uncached", 16, nullptr);
+    {
+        pipetool::SidNameCache cache;
+        run(L"cached", 1, &cache);
+    }
+    pipetool::SidNameCache cache;
+    run(L"cached", 16, &cache);
+
+    const auto path = std::filesystem::temp_directory_path() / "sid_cache_bench.tsv";
+    cache.save(path);
+    pipetool::SidNameCache reloaded;
+    if (!reloaded.load(path)) {
+        std::wcerr << L"Saved cache could not be loaded.\n";
+        return 1;
+    }
+    std::filesystem::remove(path);
+    run(L"cached (reloaded)", 16, &reloaded);
+    return lookups == 0 ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+
+#include "pipetool/pipe_client.hpp"
+#include "pipetool/platform.hpp"
+
+namespace pipetool {
+
+// Pipelined I/O over a connected PipeClient: up to `depth` writes stay in
+// flight while a read is always posted, so responses are drained as they
+// arrive instead of after the last write. Completions are serviced on the
+// calling thread whenever it has to wait (IOCP on Windows, epoll on POSIX).
+//
+// On Windows the client must have been opened with FILE_FLAG_OVERLAPPED.
+class AsyncPipe {
+public:
+    // Receives each response with ERROR_SUCCESS: a whole reassembled message on
+    // Windows, whatever one read returned from a POSIX byte stream.
+    using ResponseHandler = std::function<void(std::span<const std::byte> data, DWORD error)>;
+
+    AsyncPipe(PipeClient pipe, std::size_t depth, std::size_t slot_size, ResponseHandler on_response);
+    AsyncPipe(const AsyncPipe&) = delete;
+    AsyncPipe& operator=(const AsyncPipe&) = delete;
+    ~AsyncPipe();
+
+    const PipeClient& client() const noexcept;
+
+    // Copies data into free slots (waiting for one while all are in flight)
+    // and starts the writes. Throws std::system_error once any write has failed.
+    void write(std::span<const std::byte> data);
+
+    // Starts writes straight from caller memory, which must stay valid until
+    // flush_writes() or run_until_closed() returns.
+    void write_borrowed(std::span<const std::byte> data);
+
+    // Waits for every outstanding write, servicing responses meanwhile.
+    void flush_writes();
+
+    // Services completions until `deadline` without waiting for outstanding
+    // writes. Returns ERROR_SUCCESS while the pipe is open, or the terminal
+    // read status (ERROR_BROKEN_PIPE for an orderly close) once the server has
+    // closed its end or a read failed. Throws std::system_error once any write
+    // has failed.
+    DWORD service_until(std::chrono::steady_clock::time_point deadline);
+
+    // Finishes outstanding writes, then services responses until the server
+    // closes its end or a read fails. Returns the terminal read status, which
+    // is ERROR_BROKEN_PIPE for an orderly close.
+    DWORD run_until_closed();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace pipetool
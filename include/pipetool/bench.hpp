@@ -0,0 +1,27 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "pipetool/framing.hpp"
+
+namespace pipetool {
+
+struct BenchOptions {
+    std::size_t min_size {64};
+    std::size_t max_size {16 * 1024 * 1024};
+    // Each size step ends after `duration`, or after `byte_budget` bytes when non-zero.
+    std::chrono::milliseconds duration {1000};
+    std::uint64_t byte_budget {0};
+    // Each message is sent as one frame; `batch` frames share a gathered write.
+    FrameFormat framing;
+    std::size_t batch {1};
+};
+
+// Sweeps power-of-two message sizes over one connection and prints a
+// throughput table. Responses are not read, so run it against a discarding peer.
+int run_bench(const std::wstring& pipe_name, const BenchOptions& options);
+
+} // namespace pipetool
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "pipetool/mapped_file.hpp"
+#include "pipetool/platform.hpp"
+
+namespace pipetool {
+
+// Session captures written by --record and read back by --replay.
+//
+// A capture is the 8-byte magic "PIPECAP1" followed by records, each a 20-byte
+// little-endian header and then the payload bytes:
+//
+//   offset 0   u64  nanoseconds since the capture started
+//   offset 8   u32  payload length
+//   offset 12  u32  error code of the operation (ERROR_SUCCESS for writes)
+//   offset 16  u16  connection index
+//   offset 18  u8   direction (0 = sent, 1 = received)
+//   offset 19  u8   reserved, zero
+//
+// Records are not padded, so a mapped capture can be walked in place. A
+// payload of 4 GiB or more is written as several consecutive records.
+
+enum class CaptureDirection : std::uint8_t {
+    sent = 0,
+    received = 1,
+};
+
+struct CaptureRecord {
+    std::chrono::nanoseconds timestamp {};
+    CaptureDirection direction {CaptureDirection::sent};
+    std::uint16_t connection {0};
+    DWORD error {ERROR_SUCCESS};
+    // Points into the mapped capture; valid while the reader is alive.
+    std::span<const std::byte> payload;
+};
+
+// Appends records from any number of threads. Records are staged in memory and
+// written in large blocks, so recording costs a copy rather than a syscall.
+class CaptureWriter {
+public:
+    explicit CaptureWriter(const std::filesystem::path& path);
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+    ~CaptureWriter();
+
+    void record(CaptureDirection direction, std::uint16_t connection, DWORD error, std::span<const std::byte> payload);
+
+    // Writes staged records to the file. Throws std::runtime_error on failure.
+    void flush();
+
+private:
+    void flush_locked();
+
+    std::mutex mutex_;
+    std::ofstream stream_;
+    std::vector<std::byte> staged_;
+    std::chrono::steady_clock::time_point started_;
+};
+
+class CaptureReader {
+public:
+    explicit CaptureReader(const std::filesystem::path& path);
+
+    // Fills `record` with the next record and returns false at the end of the
+    // capture. Throws std::runtime_error if the capture is truncated or corrupt.
+    bool next(CaptureRecord& record);
+
+private:
+    MappedFile file_;
+    std::size_t offset_ {0};
+};
+
+} // namespace pipetool
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace pipetool {
+
+// CRC-32C (Castagnoli). Chains across calls: crc32c(b, crc32c(a)) equals the
+// CRC of a followed by b. Uses the SSE4.2 or ARMv8 CRC instructions when the
+// processor has them and a slicing-by-8 table otherwise.
+std::uint32_t crc32c(std::span<const std::byte> data, std::uint32_t crc = 0) noexcept;
+
+// The table implementation, for comparison in benchmarks.
+std::uint32_t crc32c_portable(std::span<const std::byte> data, std::uint32_t crc = 0) noexcept;
+
+// Whether crc32c() runs on CRC instructions.
+bool crc32c_is_hardware() noexcept;
+
+} // namespace pipetool
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "pipetool/platform.hpp"
+
+namespace pipetool {
+
+// Sequential file reader with a fixed memory footprint of
+// (read_ahead + 1) * chunk_size bytes. With read_ahead > 0 a background thread
+// keeps up to read_ahead chunks filled while the caller consumes the current one.
+class ChunkedFileReader {
+public:
+    ChunkedFileReader(const std::filesystem::path& path, std::size_t chunk_size, std::size_t read_ahead);
+    // Reads from a handle the caller keeps open, such as standard input. A
+    // pipe source yields whatever each read returns, so chunks may be short.
+    ChunkedFileReader(HANDLE handle, std::size_t chunk_size, std::size_t read_ahead);
+    ChunkedFileReader(const ChunkedFileReader&) = delete;
+    ChunkedFileReader& operator=(const ChunkedFileReader&) = delete;
+    ~ChunkedFileReader();
+
+    // Returns the next chunk, or an empty span at end of file. The span stays
+    // valid until the following call.
+    std::span<const std::byte> next();
+
+private:
+    void start(std::size_t chunk_size, std::size_t read_ahead);
+    std::size_t read_chunk(std::span<std::byte> buffer);
+    void fill_loop(std::stop_token stop);
+
+    HANDLE handle_ {INVALID_HANDLE_VALUE};
+    bool owns_handle_ {true};
+    std::vector<std::vector<std::byte>> buffers_;
+    std::vector<std::size_t> sizes_;
+
+    std::mutex mutex_;
+    std::condition_variable_any changed_;
+    std::size_t head_ {0};
+    std::size_t ready_ {0};
+    bool in_use_ {false};
+    bool end_of_file_ {false};
+    std::exception_ptr error_;
+
+    std::jthread worker_;
+};
+
+} // namespace pipetool
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "pipetool/payload_generator.hpp"
+#include "pipetool/pipe_client.hpp"
+#include "pipetool/platform.hpp"
+
+namespace pipetool {
+
+struct ReconnectPolicy {
+    // Wait before the second attempt; each later wait grows by `multiplier`
+    // up to `max_delay`. Attempts themselves wait at most `max_delay` for a
+    // free pipe instance.
+    std::chrono::milliseconds initial_delay {10};
+    std::chrono::milliseconds max_delay {1000};
+    double multiplier {2.0};
+    // Fraction of each wait that is randomised away, so clients dropped
+    // together do not retry in lockstep.
+    double jitter {0.5};
+    // Gives up once one reconnect has taken this long; 0 retries until stopped.
+    std::chrono::milliseconds deadline {0};
+    // Connections kept open in the background and handed over the moment the
+    // active one breaks. Each holds a server pipe instance.
+    std::size_t standby {0};
+};
+
+// Owns the connect side of one logical client: retries with exponential
+// backoff and jitter, and optionally keeps standby connections warm.
+class ConnectionManager {
+public:
+    // Called for each failed connect attempt.
+    using FailureHandler = std::function<void(const std::system_error& error)>;
+
+    ConnectionManager(std::wstring pipe_name, DWORD desired_access, DWORD flags_and_attributes, const ReconnectPolicy& policy,
+        std::uint64_t seed, FailureHandler on_failure);
+    ConnectionManager(const ConnectionManager&) = delete;
+    ConnectionManager& operator=(const ConnectionManager&) = delete;
+    ~ConnectionManager();
+
+    // Returns a connected client, or an invalid one if `stop` is requested or
+    // the policy deadline passes first.
+    PipeClient connect(std::stop_token stop);
+
+    // Like connect(), but prefers a healthy standby connection and is counted
+    // in reconnects() and time_reconnecting().
+    PipeClient reconnect(std::stop_token stop);
+
+    std::uint64_t reconnects() const;
+    std::chrono::nanoseconds time_reconnecting() const;
+
+private:
+    // Bounded attempts give up once the policy deadline passes.
+    PipeClient connect_with_backoff(const std::stop_token& stop, PayloadGenerator& random, bool bounded);
+    PipeClient take_standby();
+
+    const std::wstring pipe_name_;
+    const DWORD desired_access_;
+    const DWORD flags_and_attributes_;
+    const ReconnectPolicy policy_;
+    FailureHandler on_failure_;
+    PayloadGenerator random_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable_any changed_;
+    std::deque<PipeClient> standby_;
+    std::uint64_t reconnects_ {0};
+    std::chrono::nanoseconds time_reconnecting_ {0};
+
+    std::jthread filler_;
+};
+
+} // namespace pipetool
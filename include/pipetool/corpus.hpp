@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <shared_mutex>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+#include "pipetool/payload_generator.hpp"
+
+namespace pipetool {
+
+// Seed inputs for mutation fuzzing, loaded from the regular files of one
+// directory. Inputs that fault the server are written back to the same
+// directory and become seeds themselves. Entries are never removed, so an
+// index that was valid stays valid.
+class Corpus {
+public:
+    explicit Corpus(const std::filesystem::path& directory);
+    Corpus(const Corpus&) = delete;
+    Corpus& operator=(const Corpus&) = delete;
+
+    std::size_t size() const;
+    std::size_t largest() const;
+    std::size_t entry_size(std::size_t index) const;
+
+    // Copies bytes of entry `index` starting at `offset` into `out`. Returns
+    // the number of bytes copied, which is short at the end of the entry.
+    std::size_t copy(std::size_t index, std::size_t offset, std::span<std::byte> out) const;
+
+    // Saves an input that triggered a fault. Returns false for an input the
+    // corpus already holds.
+    bool add(std::span<const std::byte> input);
+
+private:
+    std::filesystem::path directory_;
+    mutable std::shared_mutex mutex_;
+    std::vector<std::vector<std::byte>> entries_;
+    std::unordered_set<std::uint64_t> hashes_;
+    std::size_t largest_ {0};
+};
+
+// Builds fuzz inputs by stacking in-place mutations on a corpus entry: bit
+// flips, byte substitutions, interesting integers, block duplication and
+// deletion, and splices from a second entry. The caller owns the buffer, so
+// producing an input does not allocate.
+class Mutator {
+public:
+    Mutator(const Corpus& corpus, std::uint64_t seed) noexcept;
+
+    // Writes the next input into `buffer` and returns its length. The buffer
+    // size caps how far mutations may grow an input.
+    std::size_t next(std::span<std::byte> buffer);
+
+private:
+    std::size_t mutate(std::span<std::byte> buffer, std::size_t size);
+
+    const Corpus& corpus_;
+    PayloadGenerator random_;
+};
+
+} // namespace pipetool
@@ -1,10 +1,54 @@
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
 #include <string>
+#include <vector>
+
+#include "pipetool/framing.hpp"
+#include "pipetool/response_matcher.hpp"
 
 namespace pipetool {
 
-int stream_file(const std::wstring& pipe_name, const std::filesystem::path& file_path);
+struct StreamOptions {
+    std::size_t chunk_size {1024 * 1024};
+    std::size_t read_ahead {2};
+    bool memory_map {false};
+    // Writes kept in flight by the async engine; 0 uses blocking I/O.
+    std::size_t async_depth {0};
+    // When set, every write and read is captured here for --replay.
+    std::filesystem::path record_path;
+    // Forwards standard input through the copy loop even where splice or
+    // sendfile could move it.
+    bool copy {false};
+    // Splits the file into this many contiguous ranges of one shared mapping
+    // and sends them concurrently, each over its own connection and preceded
+    // by a 24-byte header: offset, length and file size as little-endian u64.
+    std::size_t stripes {1};
+    // Multi-file streams only: how each file is framed. Framed files are sent
+    // whole, one frame per file; raw files are concatenated in chunks.
+    FrameFormat framing;
+    // Expects the peer to echo the stream back and checks the echo against
+    // what was sent, block by block, instead of logging it. Implies --async.
+    bool verify {false};
+    // Checks the responses against a golden file instead of logging them.
+    // Implies --async for a single file.
+    ExpectOptions expect;
+};
+
+// Streams the file into the pipe, then logs responses until the server
+// closes. A path of "-" forwards standard input until it ends; on Linux a
+// pipe or regular file there is moved with splice or sendfile.
+int stream_file(const std::wstring& pipe_name, const std::filesystem::path& file_path, const StreamOptions& options = {});
+
+// Sends the same file to every pipe concurrently, one connection and thread
+// per target, all reading from a single shared mapping. A target that is slow
+// or fails does not hold up the others; any failure fails the run.
+int broadcast_file(const std::vector<std::wstring>& pipe_names, const std::filesystem::path& file_path, const StreamOptions& options = {});
+
+// Streams the files in order over one connection. The next files are read on
+// a background thread, up to read_ahead chunks (whole files when framed) ahead
+// of the pipe. Files that cannot be read are skipped and fail the run.
+int stream_files(const std::wstring& pipe_name, const std::vector<std::filesystem::path>& files, const StreamOptions& options = {});
 
 } // namespace pipetool
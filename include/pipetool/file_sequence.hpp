@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace pipetool {
+
+// Regular files directly inside `directory`, sorted by name. Throws
+// std::filesystem::filesystem_error if the directory cannot be listed.
+std::vector<std::filesystem::path> directory_files(const std::filesystem::path& directory);
+
+// The paths a manifest lists, one per line. Blank lines and lines starting
+// with # are skipped; relative paths are taken relative to the manifest.
+// Throws std::runtime_error if the manifest cannot be read.
+std::vector<std::filesystem::path> manifest_files(const std::filesystem::path& manifest);
+
+struct FileChunk {
+    std::size_t file_index {0};
+    bool first {false};
+    bool last {false};
+    std::span<const std::byte> data;
+    // Set when the file could not be opened or read; data is then empty and
+    // no further chunks of that file follow.
+    std::error_code error;
+};
+
+// Reads a list of files in order on a background thread, staying up to
+// `read_ahead` chunks ahead of the caller across file boundaries, so later
+// files are read from disk while earlier ones are still being sent. With
+// whole_files every file is delivered as a single chunk of its full size;
+// otherwise files are split into chunks of at most chunk_size bytes.
+class FileSequenceReader {
+public:
+    FileSequenceReader(std::vector<std::filesystem::path> files, std::size_t chunk_size, std::size_t read_ahead, bool whole_files);
+    FileSequenceReader(const FileSequenceReader&) = delete;
+    FileSequenceReader& operator=(const FileSequenceReader&) = delete;
+
+    // Returns the next chunk, or nullopt after the last file. The data stays
+    // valid until the following call.
+    std::optional<FileChunk> next();
+
+    const std::filesystem::path& path(std::size_t file_index) const;
+
+private:
+    struct Slot {
+        FileChunk chunk;
+        std::vector<std::byte> buffer;
+    };
+
+    void read_loop(const std::stop_token& stop);
+    bool publish(const std::stop_token& stop, Slot slot);
+    std::vector<std::byte> take_buffer();
+
+    const std::vector<std::filesystem::path> files_;
+    const std::size_t chunk_size_;
+    const std::size_t read_ahead_;
+    const bool whole_files_;
+
+    std::mutex mutex_;
+    std::condition_variable_any changed_;
+    std::deque<Slot> ready_;
+    std::vector<std::vector<std::byte>> free_buffers_;
+    std::optional<Slot> current_;
+    bool done_ {false};
+
+    std::jthread worker_;
+};
+
+} // namespace pipetool
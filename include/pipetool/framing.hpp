@@ -0,0 +1,66 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "pipetool/pipe_client.hpp"
+
+namespace pipetool {
+
+enum class Framing : std::uint8_t {
+    // Frames are concatenated with nothing to mark where one ends.
+    raw,
+    // One write per frame, so message-mode pipes deliver each as a message.
+    message,
+    // Each frame is preceded by its length.
+    length_prefixed,
+};
+
+struct FrameFormat {
+    Framing framing {Framing::raw};
+    // Bytes in the length prefix, 2 or 4.
+    std::size_t prefix_size {4};
+    std::endian byte_order {std::endian::little};
+
+    std::size_t header_size() const noexcept;
+    std::size_t max_frame_size() const noexcept;
+};
+
+// Accepts raw, message, u16le, u16be, u32le and u32be.
+[[nodiscard]] bool parse_frame_format(std::wstring_view text, FrameFormat& format);
+
+// Frames payloads onto a pipe. Up to `batch_frames` frames are coalesced into
+// one gathered write together with their length prefixes; message framing
+// always writes frames one at a time.
+class FrameWriter {
+public:
+    FrameWriter(const PipeClient& pipe, const FrameFormat& format, std::size_t batch_frames = 1);
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    // Queues one frame. The payload is borrowed until the batch is written,
+    // which happens once the batch is full or flush() is called. Throws
+    // std::length_error if the payload does not fit the length prefix.
+    void write(std::span<const std::byte> payload);
+
+    void flush();
+
+    // Write calls issued so far.
+    std::uint64_t write_calls() const noexcept;
+
+private:
+    const PipeClient& pipe_;
+    const FrameFormat format_;
+    const std::size_t batch_frames_;
+    // One header slot per queued frame, so buffers_ can point into it.
+    std::vector<std::byte> headers_;
+    std::vector<std::span<const std::byte>> buffers_;
+    std::size_t queued_ {0};
+    std::uint64_t write_calls_ {0};
+};
+
+} // namespace pipetool
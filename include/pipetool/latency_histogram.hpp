@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pipetool {
+
+// Fixed-size, log-bucketed latency histogram in the style of HdrHistogram.
+// Every power-of-two range of nanoseconds is split into 128 linear buckets, so
+// any recorded value is reported to within 1% across the full 64-bit range.
+// Recording never allocates.
+//
+// One thread records; other threads may take a snapshot() concurrently, which
+// is how per-connection histograms are merged for interval reports.
+class LatencyHistogram {
+public:
+    void record(std::chrono::nanoseconds value) noexcept;
+
+    // Copies the current counts; safe while the owning thread records.
+    LatencyHistogram snapshot() const noexcept;
+
+    void merge(const LatencyHistogram& other) noexcept;
+
+    // Removes the samples of an earlier snapshot of this histogram, leaving the
+    // samples recorded since. max() then reports the bucket bound, not the
+    // exact value.
+    void subtract(const LatencyHistogram& earlier) noexcept;
+
+    std::uint64_t count() const noexcept;
+    std::chrono::nanoseconds max() const noexcept;
+    // Exact mean of the recorded values; zero for an empty histogram.
+    std::chrono::nanoseconds mean() const noexcept;
+
+    // Smallest recorded value bound that `percentile` percent of samples do
+    // not exceed; zero for an empty histogram.
+    std::chrono::nanoseconds percentile(double percentile) const noexcept;
+
+private:
+    static constexpr unsigned kSubBucketBits = 7;
+    static constexpr std::size_t kSubBuckets = std::size_t {1} << kSubBucketBits;
+    static constexpr std::size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    static std::size_t index_of(std::uint64_t value) noexcept;
+    static std::uint64_t highest_equivalent(std::size_t index) noexcept;
+
+    std::array<std::uint64_t, kBucketCount> counts_ {};
+    std::uint64_t count_ {0};
+    std::uint64_t max_ {0};
+    std::uint64_t sum_ {0};
+};
+
+// The percentiles reported everywhere: 50, 90, 99 and 99.9.
+inline constexpr std::array<double, 4> kReportedPercentiles {50.0, 90.0, 99.0, 99.9};
+
+// "p50 131.0 us, p90 402.3 us, p99 1.210 ms, p99.9 3.005 ms, max 4.118 ms"
+std::wstring describe_percentiles(const LatencyHistogram& histogram);
+
+} // namespace pipetool
@@ -1,20 +1,51 @@
 #pragma once
 
 #include <cstddef>
+#include <memory>
 #include <span>
 #include <string>
 #include <string_view>
 #include <system_error>
 
-#include <windows.h>
-#include <windows.h>
+#include "pipetool/platform.hpp"
 
 namespace pipetool::logging {
 
+// What producers do when the asynchronous sink's queue is full.
+enum class OverflowPolicy {
+    drop,  // discard the record and report the count later
+    block, // wait for the writer thread to free a slot
+};
+
+class AsyncSink;
+
+// While alive, log_message only enqueues a copy of each record and a
+// background thread formats and writes them in batches, so callers never wait
+// on the console. Every thread that logs must stop doing so before the scope
+// ends; destruction writes whatever is still queued.
+class AsyncScope {
+public:
+    explicit AsyncScope(std::size_t capacity = 4096, OverflowPolicy policy = OverflowPolicy::drop);
+    AsyncScope(const AsyncScope&) = delete;
+    AsyncScope& operator=(const AsyncScope&) = delete;
+    ~AsyncScope();
+
+private:
+    std::unique_ptr<AsyncSink> sink_;
+};
+
+// Waits until every record queued so far has been written. No-op when logging
+// is synchronous.
+void flush();
+
 void log_message(std::wstring_view label, DWORD error_code);
 
 void log_message(std::wstring_view label, DWORD error_code, std::span<const std::byte> payload);
 
+// Renders the hex dump that log_message prints for a payload, replacing the
+// contents of `out`.
+void format_hex_dump(std::span<const std::byte> payload, std::wstring& out);
+
 std::wstring format_error(DWORD error_code);
 
 void log_system_error(std::wstring_view label, const std::system_error& error);
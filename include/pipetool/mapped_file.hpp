@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace pipetool {
+
+// Read-only view of an entire file. Pages are faulted in on demand, so callers
+// that walk the mapping sequentially can keep residency bounded by prefetching
+// just ahead of the cursor and releasing what they have finished with.
+class MappedFile {
+public:
+    MappedFile() noexcept = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    static MappedFile open(const std::filesystem::path& path);
+
+    std::span<const std::byte> bytes() const noexcept;
+
+    // Hints that the range will be read soon.
+    void prefetch(std::span<const std::byte> range) const noexcept;
+
+    // Drops the range from the working set; later access faults it back in.
+    void release(std::span<const std::byte> range) const noexcept;
+
+private:
+    MappedFile(std::byte* data, std::size_t size) noexcept;
+
+    void close() noexcept;
+
+    std::byte* data_ {nullptr};
+    std::size_t size_ {0};
+};
+
+} // namespace pipetool
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "pipetool/pipe_client.hpp"
+#include "pipetool/platform.hpp"
+
+namespace pipetool {
+
+// Growable byte buffer that keeps its capacity across reuse and never
+// zero-fills, so reading into it costs nothing beyond the read itself.
+class MessageBuffer {
+public:
+    MessageBuffer() noexcept = default;
+    MessageBuffer(MessageBuffer&& other) noexcept;
+    MessageBuffer& operator=(MessageBuffer&& other) noexcept;
+
+    std::span<const std::byte> data() const noexcept;
+    std::size_t size() const noexcept;
+    std::size_t capacity() const noexcept;
+
+    // Returns all free space after the contents, growing it to at least `minimum` bytes.
+    std::span<std::byte> prepare(std::size_t minimum);
+
+    // Appends `count` bytes that were written into the space from prepare().
+    void commit(std::size_t count) noexcept;
+
+    void clear() noexcept;
+
+private:
+    std::unique_ptr<std::byte[]> storage_;
+    std::size_t capacity_ {0};
+    std::size_t size_ {0};
+};
+
+// Recycles message buffers, so readers created per connection stop
+// allocating once the pool has warmed up.
+class BufferPool {
+public:
+    MessageBuffer acquire();
+    void release(MessageBuffer buffer);
+
+    // Pool shared by the whole process.
+    static BufferPool& shared();
+
+private:
+    std::mutex mutex_;
+    std::vector<MessageBuffer> free_;
+};
+
+// Reassembles message-mode responses that arrive as ERROR_MORE_DATA
+// fragments. Each fragment is read straight into the tail of a pooled buffer,
+// and reads double in size, so a multi-MB message takes a handful of reads and
+// no copies. POSIX byte streams have no boundaries; each read is a message.
+class MessageReader {
+public:
+    explicit MessageReader(const PipeClient& pipe, BufferPool& pool = BufferPool::shared());
+    MessageReader(const MessageReader&) = delete;
+    MessageReader& operator=(const MessageReader&) = delete;
+    ~MessageReader();
+
+    struct Message {
+        // Valid until the next call to next().
+        std::span<const std::byte> data;
+        // ERROR_SUCCESS for a whole message; otherwise the read error, with
+        // `data` holding whatever arrived before it.
+        DWORD error;
+    };
+
+    // Blocks for the next message. An empty message with ERROR_SUCCESS means
+    // the pipe has nothing more to deliver.
+    Message next();
+
+private:
+    const PipeClient& pipe_;
+    BufferPool& pool_;
+    MessageBuffer buffer_;
+};
+
+} // namespace pipetool
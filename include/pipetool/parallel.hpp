@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace pipetool {
+
+// Runs task(0) through task(count - 1) on up to `workers` threads. Each thread
+// takes the next index as soon as it is free, so one slow task does not hold
+// up the rest. Returns once every task has finished, rethrowing the first
+// exception a task threw.
+void run_parallel(std::size_t count, std::size_t workers, const std::function<void(std::size_t index)>& task);
+
+} // namespace pipetool
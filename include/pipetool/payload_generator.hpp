@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace pipetool {
+
+// Seedable wyrand generator for fuzz payloads. Output i is a pure function of
+// seed + i * increment, so fill() computes several words independently per
+// iteration and still yields exactly the sequence next() would. Equal seeds
+// give identical payload streams, which is what makes a run replayable.
+class PayloadGenerator {
+public:
+    explicit PayloadGenerator(std::uint64_t seed) noexcept;
+
+    std::uint64_t next() noexcept;
+
+    // Uniform value in [low, high]. Uses a multiply-shift reduction; the bias
+    // is below range / 2^64 and irrelevant for payload sizes.
+    std::size_t uniform(std::size_t low, std::size_t high) noexcept;
+
+    void fill(std::span<std::byte> buffer) noexcept;
+
+    // Derives an independent seed, e.g. one per connection, from a base seed.
+    static std::uint64_t derive_seed(std::uint64_t seed, std::uint64_t stream) noexcept;
+
+private:
+    std::uint64_t state_;
+};
+
+} // namespace pipetool
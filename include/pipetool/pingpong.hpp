@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace pipetool {
+
+struct PingPongOptions {
+    std::size_t message_size {64};
+    // The run ends after `duration`, or after `round_trips` when non-zero.
+    std::chrono::milliseconds duration {5000};
+    std::uint64_t round_trips {0};
+    // Spin on PeekNamedPipe / poll instead of blocking in ReadFile / read.
+    bool busy_poll {false};
+    // Pins the measuring thread to this logical processor.
+    std::optional<unsigned> cpu;
+    // Reads replies from a second pipe, for peers such as FIFOs that carry one
+    // direction each. It is opened before the request pipe, so a peer should
+    // open its end of the reply pipe first.
+    std::wstring reply_pipe;
+};
+
+// Sends one fixed-size message at a time and waits for the peer's reply before
+// sending the next, then prints round-trip percentiles. Run it against an echo
+// peer: a reply is complete once as many bytes as were sent have come back, or
+// at the end of a reply message on message-mode pipes.
+int run_pingpong(const std::wstring& pipe_name, const PingPongOptions& options);
+
+} // namespace pipetool
@@ -1,13 +1,19 @@
-#include <utility>
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <span>
 #include <string>
-#include <windows.h>
+#include <utility>
+
+#include "pipetool/platform.hpp"
 
 namespace pipetool {
 
+// Expands a bare pipe name the way PipeClient::connect does: into the
+// \\.\pipe\ namespace on Windows, under $PIPETOOL_PIPE_DIR (default /tmp) on POSIX.
+std::wstring qualify_pipe_name(const std::wstring& pipe_name);
+
 class PipeClient {
 public:
     PipeClient() noexcept = default;
@@ -17,7 +23,11 @@ public:
     PipeClient& operator=(PipeClient&& other) noexcept;
     ~PipeClient();
 
-    static PipeClient connect(const std::wstring& pipe_name, DWORD desired_access, DWORD share_mode, DWORD flags_and_attributes);
+    // How long connect() waits for a free pipe instance by default.
+    static constexpr std::chrono::milliseconds kDefaultConnectTimeout {5000};
+
+    static PipeClient connect(const std::wstring& pipe_name, DWORD desired_access, DWORD share_mode, DWORD flags_and_attributes,
+        std::chrono::milliseconds timeout = kDefaultConnectTimeout);
 
     bool is_valid() const noexcept;
 
@@ -25,7 +35,12 @@ public:
 
     std::wstring qualified_name() const;
 
-    void write(std::span<const std::byte> buffer) const;
+    // Writes the whole buffer; returns the number of write calls it took.
+    std::size_t write(std::span<const std::byte> buffer) const;
+
+    // Writes the buffers back to back as one stream of bytes, gathered into as
+    // few write calls as the platform allows; returns the number it took.
+    std::size_t write_gathered(std::span<const std::span<const std::byte>> buffers) const;
 
     struct ReadResult {
         DWORD bytes_transferred;
@@ -34,6 +49,12 @@ public:
 
     ReadResult read(std::span<std::byte> buffer) const;
 
+    // Reports how many bytes can be read without blocking.
+    ReadResult peek() const;
+
+    // Waits until the server has consumed everything written so far.
+    DWORD flush() const noexcept;
+
 private:
     explicit PipeClient(HANDLE handle, std::wstring full_name) noexcept;
 
@@ -41,6 +62,10 @@ private:
 
     HANDLE handle_ {INVALID_HANDLE_VALUE};
     std::wstring full_name_;
+#if !defined(_WIN32)
+    bool is_socket_ {false};
+    bool readable_ {false};
+#endif
 };
 
 } // namespace pipetool
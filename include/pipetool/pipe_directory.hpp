@@ -0,0 +1,29 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pipetool {
+
+// Where bare pipe names live: the \\.\pipe\ namespace on Windows,
+// $PIPETOOL_PIPE_DIR (default /tmp) on POSIX.
+std::filesystem::path pipe_directory();
+
+// Bare names of the pipes that currently exist. On POSIX these are the
+// sockets and FIFOs in pipe_directory(). Throws std::system_error if the
+// namespace cannot be listed.
+std::vector<std::wstring> list_pipes();
+
+bool has_wildcards(std::wstring_view pattern);
+
+// Matches `*` (any run) and `?` (any one character); case-insensitive on
+// Windows, where pipe names are.
+bool glob_match(std::wstring_view pattern, std::wstring_view name);
+
+// Replaces each pattern with wildcards by the sorted pipes it matches; other
+// names pass through unchanged. The namespace is listed at most once.
+std::vector<std::wstring> expand_pipe_patterns(const std::vector<std::wstring>& patterns);
+
+} // namespace pipetool
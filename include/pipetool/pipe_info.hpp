@@ -1,9 +1,57 @@
 #pragma once
 
+#include <cstddef>
+#include <filesystem>
+#include <iosfwd>
 #include <string>
+#include <vector>
+
+#include "pipetool/platform.hpp"
 
 namespace pipetool {
 
-int show_pipe_info(const std::wstring& pipe_name);
+struct AceInfo {
+    std::wstring type;
+    std::wstring account;
+    std::wstring sid;
+    std::wstring rights;
+};
+
+struct PipeInfo {
+    std::wstring name;
+    std::wstring type;
+    std::wstring read_mode;
+    std::wstring wait_mode;
+    DWORD current_instances {0};
+    DWORD max_instances {0};
+    DWORD inbound_quota {0};
+    DWORD outbound_quota {0};
+    DWORD collect_timeout {0};
+    std::wstring server_user;
+    // Empty when the security descriptor could not be read.
+    std::wstring owner;
+    std::wstring owner_sid;
+    std::vector<AceInfo> dacl;
+    // Set instead of entries when there is no DACL or it could not be read.
+    std::wstring dacl_note;
+};
+
+struct InfoOptions {
+    // Pipes queried at once. SID lookups dominate and mostly wait on the
+    // network, so this is well above the core count.
+    std::size_t jobs {8};
+    // When set, resolved account names are loaded from and saved to this file.
+    std::filesystem::path sid_cache;
+};
+
+// Connects to the pipe and reads its metadata. Account names go through
+// SidNameCache::shared(). Throws std::system_error if the pipe cannot be opened.
+PipeInfo query_pipe_info(const std::wstring& pipe_name);
+
+void print_pipe_info(const PipeInfo& info, std::wostream& out);
+
+// Queries every named pipe, with wildcards expanded, in parallel and prints
+// the results in the order given.
+int show_pipe_info(const std::vector<std::wstring>& patterns, const InfoOptions& options);
 
 } // namespace pipetool
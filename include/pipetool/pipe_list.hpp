@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <regex>
+#include <string>
+#include <string_view>
+
+namespace pipetool {
+
+struct ListOptions {
+    // Glob with * and ?, or an ECMAScript regex searched for in each name.
+    std::wstring pattern {L"*"};
+    bool regex {false};
+    // Opens every matching pipe to report its metadata. This takes a pipe
+    // instance for a moment, as --info does.
+    bool details {false};
+    std::size_t jobs {8};
+    // Windows only: resolved account names are loaded from and saved to this file.
+    std::filesystem::path sid_cache;
+};
+
+// A --list pattern, compiled once and matched against every pipe name.
+class PipeNameFilter {
+public:
+    // Throws std::regex_error if a regex pattern does not compile.
+    PipeNameFilter(std::wstring pattern, bool regex);
+
+    bool matches(std::wstring_view name) const;
+
+private:
+    std::wstring glob_;
+    std::wregex regex_;
+    bool is_regex_;
+};
+
+// Prints the matching pipes, sorted by name, as a tab-separated table with a
+// header row. With details the pipes are queried in parallel, and a pipe that
+// cannot be queried gets its error in the status column rather than failing
+// the whole listing.
+int show_pipe_list(const ListOptions& options);
+
+} // namespace pipetool
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pipetool {
+
+enum class ServeMode : std::uint8_t {
+    // Sends every message back to its client.
+    echo,
+    // Reads and discards everything.
+    sink,
+    // Answers every message with the same fixed reply.
+    reply,
+};
+
+struct ServeOptions {
+    // Pipe instances created; on POSIX, clients served at once on the socket.
+    std::size_t instances {4};
+    ServeMode mode {ServeMode::echo};
+    std::vector<std::byte> reply;
+    // Per-instance read size, and the pipe buffer size requested on Windows.
+    std::size_t buffer_size {64 * 1024};
+    // Disconnects a client that has sent nothing for this long; 0 never does.
+    // Clients that read until the server hangs up, like --stream-file, need it.
+    std::chrono::milliseconds idle_timeout {0};
+};
+
+struct InstanceStats {
+    std::uint64_t connections {0};
+    std::uint64_t messages {0};
+    std::uint64_t bytes_received {0};
+    std::uint64_t bytes_sent {0};
+};
+
+// Listening side of a pipe: `instances` named pipe instances on Windows, a
+// Unix-domain socket on POSIX. All instances are serviced on the calling
+// thread from one completion port or epoll set. POSIX byte streams have no
+// message boundaries, so there each read counts as a message.
+class PipeServer {
+public:
+    // Throws std::system_error if the pipe or socket cannot be created.
+    PipeServer(const std::wstring& pipe_name, const ServeOptions& options);
+    PipeServer(const PipeServer&) = delete;
+    PipeServer& operator=(const PipeServer&) = delete;
+    ~PipeServer();
+
+    // Services clients for up to `timeout`.
+    void run_for(std::chrono::milliseconds timeout);
+
+    const std::vector<InstanceStats>& stats() const noexcept;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace pipetool
@@ -0,0 +1,39 @@
+#pragma once
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+#else
+
+#include <cerrno>
+#include <cstdint>
+
+// POSIX builds keep the Win32 vocabulary used throughout pipetool. Handles are
+// file descriptors and error codes carry errno values, so format_error and
+// std::system_category describe them correctly.
+
+using DWORD = std::uint32_t;
+using HANDLE = int;
+
+inline constexpr HANDLE INVALID_HANDLE_VALUE = -1;
+
+inline constexpr DWORD ERROR_SUCCESS = 0;
+inline constexpr DWORD ERROR_BROKEN_PIPE = EPIPE;
+inline constexpr DWORD ERROR_PIPE_NOT_CONNECTED = ENOTCONN;
+inline constexpr DWORD ERROR_NO_DATA = ECONNRESET;
+inline constexpr DWORD ERROR_MORE_DATA = EMSGSIZE;
+inline constexpr DWORD ERROR_INVALID_PARAMETER = EINVAL;
+inline constexpr DWORD ERROR_OPERATION_ABORTED = ECANCELED;
+inline constexpr DWORD ERROR_TIMEOUT = ETIMEDOUT;
+inline constexpr DWORD ERROR_CRC = EBADMSG;
+
+inline constexpr DWORD GENERIC_READ = 0x80000000u;
+inline constexpr DWORD GENERIC_WRITE = 0x40000000u;
+inline constexpr DWORD READ_CONTROL = 0x00020000u;
+inline constexpr DWORD FILE_SHARE_READ = 0x00000001u;
+inline constexpr DWORD FILE_SHARE_WRITE = 0x00000002u;
+inline constexpr DWORD FILE_ATTRIBUTE_NORMAL = 0x00000080u;
+inline constexpr DWORD FILE_FLAG_OVERLAPPED = 0x40000000u;
+
+#endif
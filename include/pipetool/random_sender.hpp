@@ -1,10 +1,39 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
 #include <string>
 
+#include "pipetool/connection_manager.hpp"
+
 namespace pipetool {
 
-int fuzz_pipe(const std::wstring& pipe_name, std::size_t max_payload_size);
+struct FuzzOptions {
+    std::size_t max_payload_size {100};
+    // Client instances driven concurrently, each on its own worker thread.
+    std::size_t connections {1};
+    // Open-loop pacing per connection: payloads per second and bytes per
+    // second, whichever is slower governs. 0 lifts that limit; with both at 0
+    // payloads go out as fast as the pipe accepts them.
+    std::size_t rate {0};
+    std::uint64_t bytes_per_second {0};
+    // Logs latency percentiles for each interval of this length; 0 reports
+    // only the totals at exit.
+    std::chrono::milliseconds report_interval {0};
+    // Replays an earlier run exactly; a clock-derived seed is used and logged otherwise.
+    std::optional<std::uint64_t> seed;
+    // When set, inputs are mutations of the files in this directory rather
+    // than random bytes, and inputs that fault the server are saved there.
+    std::filesystem::path corpus_directory;
+    // When set, every payload and read result is captured here for --replay.
+    std::filesystem::path record_path;
+    // Backoff, deadline and standby connections used when the server drops a client.
+    ReconnectPolicy reconnect;
+};
+
+int fuzz_pipe(const std::wstring& pipe_name, const FuzzOptions& options);
 
 } // namespace pipetool
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+#include "pipetool/response_matcher.hpp"
+
+namespace pipetool {
+
+struct ReplayOptions {
+    // Reproduces the recorded gaps between writes; otherwise sends flat out.
+    bool paced {true};
+    // Checks the responses against a golden file; the server must then close
+    // the connection. Only captures of a single connection can be checked.
+    ExpectOptions expect;
+};
+
+// Re-sends the payloads of a --record capture, one pipe connection per
+// recorded connection. Responses are drained and counted but not logged.
+int replay_capture(const std::wstring& pipe_name, const std::filesystem::path& capture_path, const ReplayOptions& options = {});
+
+} // namespace pipetool
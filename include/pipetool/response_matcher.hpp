@@ -0,0 +1,60 @@
+#pragma once
+
+#include "pipetool/mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace pipetool {
+
+// Bytes of the expected output that may differ, such as timestamps or nonces.
+struct MaskRange {
+    std::uint64_t offset {0};
+    std::uint64_t length {0};
+};
+
+struct ExpectOptions {
+    // Golden response stream; empty disables the check.
+    std::filesystem::path path;
+    std::vector<MaskRange> masks;
+};
+
+// Compares a response stream with a memory-mapped golden file as it arrives,
+// outside the masked ranges, and logs the first divergence with a hex dump
+// of both sides around it. Nothing is buffered beyond a few bytes of context.
+class ResponseMatcher {
+public:
+    explicit ResponseMatcher(const ExpectOptions& options);
+
+    void received(std::span<const std::byte> bytes);
+
+    // Checks that the stream was neither short nor long, and logs a summary.
+    // Call once the stream has ended. Returns true if it matched.
+    bool finish();
+
+private:
+    void compare(std::span<const std::byte> bytes);
+    void report(std::span<const std::byte> bytes, std::size_t index);
+    void remember(std::span<const std::byte> bytes);
+
+    std::filesystem::path path_;
+    MappedFile expected_;
+    // Sorted, merged and clipped to the expected output.
+    std::vector<MaskRange> masks_;
+    std::uint64_t position_ {0};
+    // Start of the part of the mapping not yet released from the working set.
+    std::uint64_t resident_ {0};
+    std::optional<std::uint64_t> divergence_;
+    // The last bytes received, for the context before a divergence.
+    std::vector<std::byte> history_;
+};
+
+// Opens the golden file named in `options`, if any, reporting a failure on
+// the console. Returns false if it could not be opened.
+[[nodiscard]] bool open_expected(const ExpectOptions& options, std::optional<ResponseMatcher>& matcher);
+
+} // namespace pipetool
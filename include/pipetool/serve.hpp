@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+#include "pipetool/pipe_server.hpp"
+
+namespace pipetool {
+
+// Serves the pipe until the user stops it, then prints per-instance throughput.
+int serve_pipe(const std::wstring& pipe_name, const ServeOptions& options);
+
+} // namespace pipetool
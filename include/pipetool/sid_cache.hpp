@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace pipetool {
+
+// Maps SIDs, in their S-1-... string form, to account names. LookupAccountSidW
+// can take tens of milliseconds, or hang on an unreachable domain controller,
+// and every pipe asks about the same few SIDs. Lookups are single-flight:
+// callers that miss on a SID already being looked up wait for that lookup
+// instead of starting another.
+class SidNameCache {
+public:
+    // Returns the account name, or nullopt if the SID does not resolve.
+    using Lookup = std::function<std::optional<std::wstring>()>;
+
+    std::optional<std::wstring> resolve(const std::wstring& sid, const Lookup& lookup);
+
+    // Adds the names saved by save(). Returns false if the file cannot be read.
+    bool load(const std::filesystem::path& path);
+
+    // Writes every resolved name as UTF-8 "sid<TAB>name" lines. Throws
+    // std::runtime_error on failure.
+    void save(const std::filesystem::path& path) const;
+
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+
+    // Cache shared by the whole process.
+    static SidNameCache& shared();
+
+private:
+    using Entry = std::shared_future<std::optional<std::wstring>>;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::wstring, Entry> entries_;
+    std::uint64_t hits_ {0};
+    std::uint64_t misses_ {0};
+};
+
+} // namespace pipetool
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace pipetool {
+
+// Long-running subcommands poll user_requested_stop() from their main loop.
+// Any key stops them on Windows; Ctrl+C does on POSIX once the handler is installed.
+void install_stop_handler();
+
+bool user_requested_stop();
+
+} // namespace pipetool
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace pipetool {
+
+// Checks that an echo peer returned exactly the bytes sent, without keeping
+// either stream. Both streams are cut into fixed-size blocks at the same
+// offsets and each block is reduced to its CRC-32C as it passes; blocks are
+// compared as soon as both sides have them, and a mismatch is logged with
+// the byte range it covers.
+//
+// sent() and received() may run on different threads, but each must only
+// be called from one thread at a time.
+class StreamVerifier {
+public:
+    static constexpr std::size_t kDefaultBlockSize = 4096;
+
+    explicit StreamVerifier(std::size_t block_size = kDefaultBlockSize);
+
+    void sent(std::span<const std::byte> bytes);
+    void received(std::span<const std::byte> bytes);
+
+    // Compares the final partial blocks and the stream lengths, and logs a
+    // summary. Call once both streams have ended. Returns true if they match.
+    bool finish();
+
+private:
+    struct Side {
+        // Bytes seen; only read by others once the side's thread is done.
+        std::uint64_t total {0};
+        std::uint32_t crc {0};
+        std::size_t fill {0};
+        std::deque<std::uint32_t> blocks;
+        // Completed blocks not yet handed over; only touched by the side's thread.
+        std::vector<std::uint32_t> completed;
+    };
+
+    void append(Side& side, std::span<const std::byte> bytes);
+    // Compares the blocks both sides have; `end` caps the logged byte ranges.
+    void compare_locked(std::uint64_t end = UINT64_MAX);
+
+    const std::size_t block_size_;
+    Side sent_;
+    Side received_;
+
+    std::mutex mutex_;
+    std::uint64_t compared_ {0};
+    std::uint64_t mismatches_ {0};
+};
+
+} // namespace pipetool
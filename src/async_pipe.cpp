@@ -0,0 +1,300 @@
+#include "pipetool/async_pipe.hpp"
+
+#include "pipetool/message_reader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <windows.h>
+
+namespace pipetool {
+namespace {
+
+[[noreturn]] void throw_error(DWORD error, const char* context) {
+    throw std::system_error(static_cast<int>(error), std::system_category(), context);
+}
+
+constexpr ULONG_PTR kCompletionKey = 1;
+constexpr std::size_t kInitialRead = 4096;
+
+} // namespace
+
+struct AsyncPipe::Impl {
+    // OVERLAPPED must stay the first member so a completion can be mapped back
+    // to its operation.
+    struct Operation {
+        OVERLAPPED overlapped {};
+        std::size_t slot {0};
+        bool is_read {false};
+    };
+
+    PipeClient pipe;
+    HANDLE port {nullptr};
+
+    std::size_t slot_size {0};
+    std::vector<std::vector<std::byte>> slots;
+    std::vector<Operation> writes;
+    std::vector<std::size_t> free_slots;
+    std::size_t outstanding_writes {0};
+    DWORD write_error {ERROR_SUCCESS};
+
+    Operation read_op {};
+    // Fragments of a message-mode response accumulate here until the last one.
+    MessageBuffer message;
+    std::size_t read_request {kInitialRead};
+    bool read_pending {false};
+    bool closed {false};
+    DWORD read_error {ERROR_SUCCESS};
+
+    ResponseHandler on_response;
+
+    void post_read() {
+        if (closed || read_pending) {
+            return;
+        }
+        read_op = {};
+        read_op.is_read = true;
+        const std::span<std::byte> space = message.prepare(read_request);
+        const DWORD request = static_cast<DWORD>(std::min<std::size_t>(space.size(), std::numeric_limits<DWORD>::max()));
+        // With a completion port attached, every outcome other than an
+        // immediate failure is reported through the port.
+        if (!::ReadFile(pipe.native_handle(), space.data(), request, nullptr, &read_op.overlapped)) {
+            const DWORD error = ::GetLastError();
+            if (error != ERROR_IO_PENDING && error != ERROR_MORE_DATA) {
+                closed = true;
+                read_error = error;
+                return;
+            }
+        }
+        read_pending = true;
+    }
+
+    void complete_read(DWORD bytes, DWORD error) {
+        read_pending = false;
+        if (error == ERROR_SUCCESS && bytes == 0) {
+            closed = true;
+            read_error = ERROR_SUCCESS;
+            return;
+        }
+        if (error != ERROR_SUCCESS && error != ERROR_MORE_DATA) {
+            closed = true;
+            read_error = error;
+            return;
+        }
+        message.commit(bytes);
+        if (error == ERROR_MORE_DATA) {
+            // Read the rest straight into the tail, doubling each time.
+            read_request = message.size();
+        } else {
+            on_response(message.data(), ERROR_SUCCESS);
+            message.clear();
+            read_request = kInitialRead;
+        }
+        post_read();
+    }
+
+    void complete_write(Operation& operation, DWORD error) {
+        if (error != ERROR_SUCCESS && write_error == ERROR_SUCCESS) {
+            write_error = error;
+        }
+        --outstanding_writes;
+        free_slots.push_back(operation.slot);
+    }
+
+    bool idle() const {
+        return outstanding_writes == 0 && !read_pending;
+    }
+
+    // Waits up to `timeout` milliseconds (INFINITE for no limit) for completions.
+    void pump(DWORD timeout) {
+        if (idle()) {
+            return;
+        }
+
+        std::array<OVERLAPPED_ENTRY, 16> entries {};
+        ULONG count = 0;
+        if (!::GetQueuedCompletionStatusEx(port, entries.data(), static_cast<ULONG>(entries.size()), &count, timeout, FALSE)) {
+            const DWORD error = ::GetLastError();
+            if (error == WAIT_TIMEOUT) {
+                return;
+            }
+            throw_error(error, "GetQueuedCompletionStatusEx");
+        }
+
+        for (ULONG index = 0; index < count; ++index) {
+            auto* operation = reinterpret_cast<Operation*>(entries[index].lpOverlapped);
+            DWORD bytes = 0;
+            DWORD error = ERROR_SUCCESS;
+            if (!::GetOverlappedResult(pipe.native_handle(), &operation->overlapped, &bytes, FALSE)) {
+                error = ::GetLastError();
+            }
+            if (operation->is_read) {
+                complete_read(bytes, error);
+            } else {
+                complete_write(*operation, error);
+            }
+        }
+    }
+
+    void throw_if_write_failed() const {
+        if (write_error != ERROR_SUCCESS) {
+            throw_error(write_error, "WriteFile");
+        }
+    }
+
+    std::size_t acquire_slot() {
+        while (free_slots.empty()) {
+            throw_if_write_failed();
+            pump(INFINITE);
+        }
+        throw_if_write_failed();
+        const std::size_t slot = free_slots.back();
+        free_slots.pop_back();
+        return slot;
+    }
+
+    void submit(const std::byte* data, DWORD size, std::size_t slot) {
+        Operation& operation = writes[slot];
+        operation = {};
+        operation.slot = slot;
+        if (!::WriteFile(pipe.native_handle(), data, size, nullptr, &operation.overlapped)) {
+            const DWORD error = ::GetLastError();
+            if (error != ERROR_IO_PENDING) {
+                free_slots.push_back(slot);
+                throw_error(error, "WriteFile");
+            }
+        }
+        ++outstanding_writes;
+        post_read();
+    }
+
+    void cancel_all() noexcept {
+        if (outstanding_writes == 0 && !read_pending) {
+            return;
+        }
+        ::CancelIoEx(pipe.native_handle(), nullptr);
+        try {
+            while (outstanding_writes > 0 || read_pending) {
+                pump(INFINITE);
+            }
+        } catch (...) {
+        }
+    }
+};
+
+AsyncPipe::AsyncPipe(PipeClient pipe, std::size_t depth, std::size_t slot_size, ResponseHandler on_response)
+    : impl_(std::make_unique<Impl>()) {
+    if (depth == 0 || slot_size == 0) {
+        throw std::invalid_argument("async depth and slot size must be greater than zero");
+    }
+
+    Impl& impl = *impl_;
+    impl.pipe = std::move(pipe);
+    impl.on_response = std::move(on_response);
+    impl.slot_size = std::min<std::size_t>(slot_size, std::numeric_limits<DWORD>::max());
+    impl.slots.resize(depth);
+    impl.writes.resize(depth);
+    for (std::size_t slot = 0; slot < depth; ++slot) {
+        impl.free_slots.push_back(depth - 1 - slot);
+    }
+    impl.message = BufferPool::shared().acquire();
+
+    impl.port = ::CreateIoCompletionPort(impl.pipe.native_handle(), nullptr, kCompletionKey, 1);
+    if (impl.port == nullptr) {
+        throw_error(::GetLastError(), "CreateIoCompletionPort");
+    }
+}
+
+AsyncPipe::~AsyncPipe() {
+    if (!impl_) {
+        return;
+    }
+    // Outstanding operations reference our buffers; they must finish first.
+    impl_->cancel_all();
+    if (impl_->port != nullptr) {
+        ::CloseHandle(impl_->port);
+    }
+    BufferPool::shared().release(std::move(impl_->message));
+}
+
+const PipeClient& AsyncPipe::client() const noexcept {
+    return impl_->pipe;
+}
+
+void AsyncPipe::write(std::span<const std::byte> data) {
+    Impl& impl = *impl_;
+    while (!data.empty()) {
+        const std::size_t slot = impl.acquire_slot();
+        const std::size_t size = std::min(data.size(), impl.slot_size);
+        auto& buffer = impl.slots[slot];
+        buffer.resize(impl.slot_size);
+        std::memcpy(buffer.data(), data.data(), size);
+        impl.submit(buffer.data(), static_cast<DWORD>(size), slot);
+        data = data.subspan(size);
+    }
+}
+
+void AsyncPipe::write_borrowed(std::span<const std::byte> data) {
+    Impl& impl = *impl_;
+    while (!data.empty()) {
+        const std::size_t slot = impl.acquire_slot();
+        const std::size_t size = std::min<std::size_t>(data.size(), std::numeric_limits<DWORD>::max());
+        impl.submit(data.data(), static_cast<DWORD>(size), slot);
+        data = data.subspan(size);
+    }
+}
+
+void AsyncPipe::flush_writes() {
+    Impl& impl = *impl_;
+    while (impl.outstanding_writes > 0) {
+        impl.pump(INFINITE);
+    }
+    impl.throw_if_write_failed();
+}
+
+DWORD AsyncPipe::run_until_closed() {
+    flush_writes();
+    Impl& impl = *impl_;
+    impl.post_read();
+    while (!impl.closed) {
+        impl.pump(INFINITE);
+    }
+    // As in service_until, a zero-byte read reports the close as a broken pipe.
+    return impl.read_error == ERROR_SUCCESS ? ERROR_BROKEN_PIPE : impl.read_error;
+}
+
+DWORD AsyncPipe::service_until(std::chrono::steady_clock::time_point deadline) {
+    Impl& impl = *impl_;
+    impl.post_read();
+    impl.pump(0);
+    while (!impl.closed) {
+        const auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::steady_clock::duration::zero()) {
+            break;
+        }
+        const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count();
+        if (impl.idle() || milliseconds == 0) {
+            std::this_thread::sleep_until(deadline);
+            impl.pump(0);
+            break;
+        }
+        impl.pump(static_cast<DWORD>(std::min<long long>(milliseconds, INFINITE - 1)));
+    }
+    impl.throw_if_write_failed();
+    if (!impl.closed) {
+        return ERROR_SUCCESS;
+    }
+    // A zero-byte read marks an orderly close, which callers treat as a broken pipe.
+    return impl.read_error == ERROR_SUCCESS ? ERROR_BROKEN_PIPE : impl.read_error;
+}
+
+} // namespace pipetool
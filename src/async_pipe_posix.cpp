@@ -0,0 +1,294 @@
+#include "pipetool/async_pipe.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace pipetool {
+namespace {
+
+[[noreturn]] void throw_error(int error, const char* context) {
+    throw std::system_error(error, std::system_category(), context);
+}
+
+} // namespace
+
+// POSIX has no kernel-side write queue for sockets and FIFOs that epoll can
+// report completions for, so "in flight" writes are slots queued here and
+// pushed into the kernel buffer whenever the descriptor is writable.
+struct AsyncPipe::Impl {
+    struct Pending {
+        const std::byte* data;
+        std::size_t size;
+        std::size_t slot;
+    };
+
+    PipeClient pipe;
+    int epoll_fd {-1};
+    std::uint32_t registered_events {0};
+    bool readable {false};
+
+    std::size_t slot_size {0};
+    std::vector<std::vector<std::byte>> slots;
+    std::vector<std::size_t> free_slots;
+    std::deque<Pending> queue;
+    int write_error {0};
+
+    std::vector<std::byte> read_buffer;
+    bool closed {false};
+    DWORD read_error {ERROR_SUCCESS};
+
+    ResponseHandler on_response;
+
+    std::uint32_t wanted_events() const {
+        std::uint32_t events = 0;
+        if (readable && !closed) {
+            events |= EPOLLIN;
+        }
+        if (!queue.empty() && write_error == 0) {
+            events |= EPOLLOUT;
+        }
+        return events;
+    }
+
+    void update_registration() {
+        const std::uint32_t events = wanted_events();
+        if (events == registered_events) {
+            return;
+        }
+        epoll_event event {};
+        event.events = events;
+        if (::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, pipe.native_handle(), &event) != 0) {
+            throw_error(errno, "epoll_ctl");
+        }
+        registered_events = events;
+    }
+
+    void complete(const Pending& pending) {
+        free_slots.push_back(pending.slot);
+    }
+
+    // Pushes queued writes into the kernel until it would block.
+    void pump_writes() {
+        while (!queue.empty() && write_error == 0) {
+            Pending& head = queue.front();
+            const ssize_t written = ::write(pipe.native_handle(), head.data, head.size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return;
+                }
+                write_error = errno;
+                return;
+            }
+            head.data += written;
+            head.size -= static_cast<std::size_t>(written);
+            if (head.size == 0) {
+                complete(head);
+                queue.pop_front();
+            }
+        }
+    }
+
+    void pump_reads() {
+        while (readable && !closed) {
+            const ssize_t read = ::read(pipe.native_handle(), read_buffer.data(), read_buffer.size());
+            if (read < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return;
+                }
+                closed = true;
+                read_error = static_cast<DWORD>(errno);
+                return;
+            }
+            if (read == 0) {
+                closed = true;
+                read_error = ERROR_BROKEN_PIPE;
+                return;
+            }
+            on_response(std::span<const std::byte>(read_buffer.data(), static_cast<std::size_t>(read)), ERROR_SUCCESS);
+        }
+    }
+
+    bool idle() const {
+        return wanted_events() == 0;
+    }
+
+    // Waits up to `timeout_ms` (-1 for no limit) for readiness and services it.
+    void pump(int timeout_ms) {
+        update_registration();
+        if (registered_events == 0) {
+            return;
+        }
+
+        std::array<epoll_event, 4> events {};
+        int count = 0;
+        do {
+            count = ::epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), timeout_ms);
+        } while (count < 0 && errno == EINTR);
+        if (count < 0) {
+            throw_error(errno, "epoll_wait");
+        }
+
+        // A single descriptor is registered, so one pass over both directions suffices.
+        if (count > 0) {
+            pump_reads();
+            pump_writes();
+        }
+    }
+
+    void throw_if_write_failed() const {
+        if (write_error != 0) {
+            throw_error(write_error, "write");
+        }
+    }
+
+    std::size_t acquire_slot() {
+        while (free_slots.empty()) {
+            throw_if_write_failed();
+            pump(-1);
+        }
+        throw_if_write_failed();
+        const std::size_t slot = free_slots.back();
+        free_slots.pop_back();
+        return slot;
+    }
+
+    void submit(const std::byte* data, std::size_t size, std::size_t slot) {
+        const bool was_idle = queue.empty();
+        queue.push_back({data, size, slot});
+        if (was_idle) {
+            pump_writes();
+        }
+    }
+};
+
+AsyncPipe::AsyncPipe(PipeClient pipe, std::size_t depth, std::size_t slot_size, ResponseHandler on_response)
+    : impl_(std::make_unique<Impl>()) {
+    if (depth == 0 || slot_size == 0) {
+        throw std::invalid_argument("async depth and slot size must be greater than zero");
+    }
+
+    Impl& impl = *impl_;
+    impl.pipe = std::move(pipe);
+    impl.on_response = std::move(on_response);
+    impl.slot_size = slot_size;
+    impl.slots.resize(depth);
+    for (std::size_t slot = 0; slot < depth; ++slot) {
+        impl.free_slots.push_back(depth - 1 - slot);
+    }
+    impl.read_buffer.resize(4096);
+
+    const int fd = impl.pipe.native_handle();
+    const int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+        throw_error(errno, "fcntl");
+    }
+    // The write end of a FIFO has no response channel.
+    impl.readable = (flags & O_ACCMODE) != O_WRONLY;
+
+    impl.epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (impl.epoll_fd < 0) {
+        throw_error(errno, "epoll_create1");
+    }
+    epoll_event event {};
+    if (::epoll_ctl(impl.epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        const int error = errno;
+        ::close(impl.epoll_fd);
+        impl.epoll_fd = -1;
+        throw_error(error, "epoll_ctl");
+    }
+}
+
+AsyncPipe::~AsyncPipe() {
+    if (impl_ && impl_->epoll_fd >= 0) {
+        ::close(impl_->epoll_fd);
+    }
+}
+
+const PipeClient& AsyncPipe::client() const noexcept {
+    return impl_->pipe;
+}
+
+void AsyncPipe::write(std::span<const std::byte> data) {
+    Impl& impl = *impl_;
+    while (!data.empty()) {
+        const std::size_t slot = impl.acquire_slot();
+        const std::size_t size = std::min(data.size(), impl.slot_size);
+        auto& buffer = impl.slots[slot];
+        buffer.resize(impl.slot_size);
+        std::memcpy(buffer.data(), data.data(), size);
+        impl.submit(buffer.data(), size, slot);
+        data = data.subspan(size);
+    }
+}
+
+void AsyncPipe::write_borrowed(std::span<const std::byte> data) {
+    Impl& impl = *impl_;
+    if (data.empty()) {
+        return;
+    }
+    const std::size_t slot = impl.acquire_slot();
+    impl.submit(data.data(), data.size(), slot);
+}
+
+void AsyncPipe::flush_writes() {
+    Impl& impl = *impl_;
+    while (!impl.queue.empty() && impl.write_error == 0) {
+        impl.pump(-1);
+    }
+    impl.throw_if_write_failed();
+}
+
+DWORD AsyncPipe::run_until_closed() {
+    flush_writes();
+    Impl& impl = *impl_;
+    if (!impl.readable) {
+        return ERROR_SUCCESS;
+    }
+    while (!impl.closed) {
+        impl.pump(-1);
+    }
+    return impl.read_error;
+}
+
+DWORD AsyncPipe::service_until(std::chrono::steady_clock::time_point deadline) {
+    Impl& impl = *impl_;
+    impl.pump(0);
+    while (!impl.closed) {
+        const auto remaining = deadline - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::steady_clock::duration::zero()) {
+            break;
+        }
+        const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count();
+        if (impl.idle() || milliseconds == 0) {
+            // epoll_wait cannot time a sub-millisecond remainder.
+            std::this_thread::sleep_until(deadline);
+            impl.pump(0);
+            break;
+        }
+        impl.pump(static_cast<int>(std::min<long long>(milliseconds, std::numeric_limits<int>::max())));
+    }
+    impl.throw_if_write_failed();
+    return impl.closed ? impl.read_error : ERROR_SUCCESS;
+}
+
+} // namespace pipetool
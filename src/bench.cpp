@@ -0,0 +1,154 @@
+#include "pipetool/bench.hpp"
+
+#include "pipetool/framing.hpp"
+#include "pipetool/logging.hpp"
+#include "pipetool/pipe_client.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include "pipetool/platform.hpp"
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif
+
+namespace pipetool {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// CPU time consumed by the calling thread, user plus kernel.
+std::chrono::nanoseconds thread_cpu_time() {
+#if defined(_WIN32)
+    FILETIME creation {};
+    FILETIME exit {};
+    FILETIME kernel {};
+    FILETIME user {};
+    if (!::GetThreadTimes(::GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return std::chrono::nanoseconds {0};
+    }
+    const auto to_ticks = [](const FILETIME& time) {
+        return (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    return std::chrono::nanoseconds {(to_ticks(kernel) + to_ticks(user)) * 100};
+#else
+    timespec now {};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return std::chrono::seconds {now.tv_sec} + std::chrono::nanoseconds {now.tv_nsec};
+#endif
+}
+
+struct StepResult {
+    std::uint64_t messages {0};
+    std::uint64_t bytes {0};
+    std::uint64_t write_calls {0};
+    Clock::duration elapsed {};
+    std::chrono::nanoseconds cpu {};
+};
+
+StepResult run_step(const PipeClient& pipe, std::span<const std::byte> message, const BenchOptions& options) {
+    StepResult result;
+    const auto cpu_start = thread_cpu_time();
+    const auto start = Clock::now();
+    const auto deadline = start + options.duration;
+    FrameWriter writer {pipe, options.framing, options.batch};
+
+    while (true) {
+        writer.write(message);
+        ++result.messages;
+        result.bytes += message.size();
+
+        if (options.byte_budget != 0) {
+            if (result.bytes >= options.byte_budget) {
+                break;
+            }
+        } else if (Clock::now() >= deadline) {
+            break;
+        }
+    }
+
+    writer.flush();
+    result.write_calls = writer.write_calls();
+    result.elapsed = Clock::now() - start;
+    result.cpu = thread_cpu_time() - cpu_start;
+    return result;
+}
+
+// Powers of two from min_size, always finishing on max_size.
+std::vector<std::size_t> sweep_sizes(const BenchOptions& options) {
+    std::vector<std::size_t> sizes;
+    for (std::size_t size = options.min_size; size < options.max_size; size = (size > options.max_size / 2) ? options.max_size : size * 2) {
+        sizes.push_back(size);
+    }
+    sizes.push_back(options.max_size);
+    return sizes;
+}
+
+void print_header() {
+    std::wcout << std::setw(10) << L"size" << std::setw(12) << L"MB/s" << std::setw(14) << L"msgs/s"
+               << std::setw(14) << L"syscalls/msg" << std::setw(14) << L"cpu ms/GB" << L"\n";
+}
+
+void print_row(std::size_t size, const StepResult& result) {
+    const double seconds = std::max(std::chrono::duration<double>(result.elapsed).count(), 1e-9);
+    const double megabytes = static_cast<double>(result.bytes) / (1024.0 * 1024.0);
+    const double gigabytes = megabytes / 1024.0;
+    const double cpu_ms = std::chrono::duration<double, std::milli>(result.cpu).count();
+
+    std::wcout << std::fixed << std::setprecision(1)
+               << std::setw(10) << size
+               << std::setw(12) << megabytes / seconds
+               << std::setw(14) << static_cast<double>(result.messages) / seconds
+               << std::setprecision(2)
+               << std::setw(14) << static_cast<double>(result.write_calls) / static_cast<double>(result.messages)
+               << std::setprecision(1)
+               << std::setw(14) << (gigabytes > 0.0 ? cpu_ms / gigabytes : 0.0)
+               << L"\n";
+}
+
+} // namespace
+
+int run_bench(const std::wstring& pipe_name, const BenchOptions& options) {
+    if (options.min_size == 0 || options.min_size > options.max_size) {
+        std::wcerr << L"Benchmark size range is invalid.\n";
+        return EXIT_FAILURE;
+    }
+    if (options.max_size > options.framing.max_frame_size()) {
+        std::wcerr << L"Largest message does not fit the frame length prefix.\n";
+        return EXIT_FAILURE;
+    }
+
+    try {
+        PipeClient pipe = PipeClient::connect(pipe_name, GENERIC_WRITE | GENERIC_READ, 0, FILE_ATTRIBUTE_NORMAL);
+
+        std::vector<std::byte> message(options.max_size);
+        for (std::size_t index = 0; index < message.size(); ++index) {
+            message[index] = static_cast<std::byte>(index * 131u);
+        }
+
+        logging::log_message(L"Benchmark started", ERROR_SUCCESS);
+        print_header();
+
+        for (const std::size_t size : sweep_sizes(options)) {
+            print_row(size, run_step(pipe, std::span<const std::byte>(message.data(), size), options));
+        }
+
+        return EXIT_SUCCESS;
+    } catch (const std::system_error& ex) {
+        logging::log_system_error(L"Benchmark failed", ex);
+        return EXIT_FAILURE;
+    } catch (const std::exception& ex) {
+        std::cerr << "Benchmark failed: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
+
+} // namespace pipetool
@@ -0,0 +1,143 @@
+#include "pipetool/capture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace pipetool {
+namespace {
+
+constexpr std::array<char, 8> kMagic {'P', 'I', 'P', 'E', 'C', 'A', 'P', '1'};
+constexpr std::size_t kHeaderSize = 20;
+// Staged bytes are written out once they exceed this; larger payloads bypass
+// the staging buffer entirely.
+constexpr std::size_t kStageSize = 1024 * 1024;
+// Largest payload one record can describe.
+constexpr std::size_t kMaxRecordPayload = UINT32_MAX;
+
+template <typename T>
+void store_le(std::byte* out, T value) noexcept {
+    for (std::size_t index = 0; index < sizeof(T); ++index) {
+        out[index] = static_cast<std::byte>(static_cast<std::uint64_t>(value) >> (8 * index));
+    }
+}
+
+template <typename T>
+T load_le(const std::byte* in) noexcept {
+    std::uint64_t value = 0;
+    for (std::size_t index = 0; index < sizeof(T); ++index) {
+        value |= static_cast<std::uint64_t>(in[index]) << (8 * index);
+    }
+    return static_cast<T>(value);
+}
+
+} // namespace
+
+CaptureWriter::CaptureWriter(const std::filesystem::path& path)
+    : stream_(path, std::ios::binary | std::ios::trunc), started_(std::chrono::steady_clock::now()) {
+    if (!stream_) {
+        throw std::runtime_error("unable to create capture file " + path.string());
+    }
+    staged_.reserve(kStageSize + kHeaderSize);
+    const auto* magic = reinterpret_cast<const std::byte*>(kMagic.data());
+    staged_.insert(staged_.end(), magic, magic + kMagic.size());
+}
+
+CaptureWriter::~CaptureWriter() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+        // Nothing useful to do with a write failure during teardown.
+    }
+}
+
+void CaptureWriter::record(CaptureDirection direction, std::uint16_t connection, DWORD error, std::span<const std::byte> payload) {
+    std::scoped_lock lock(mutex_);
+
+    // Stamped under the lock so file order and timestamp order agree.
+    const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started_);
+
+    std::array<std::byte, kHeaderSize> header {};
+    store_le(header.data(), static_cast<std::uint64_t>(timestamp.count()));
+    store_le(header.data() + 12, static_cast<std::uint32_t>(error));
+    store_le(header.data() + 16, connection);
+    header[18] = static_cast<std::byte>(direction);
+
+    // The length field is 32 bits, so a larger payload is split across
+    // consecutive records that share the rest of the header.
+    do {
+        const auto piece = payload.first(std::min(payload.size(), kMaxRecordPayload));
+        payload = payload.subspan(piece.size());
+        store_le(header.data() + 8, static_cast<std::uint32_t>(piece.size()));
+        staged_.insert(staged_.end(), header.begin(), header.end());
+
+        if (piece.size() >= kStageSize) {
+            flush_locked();
+            stream_.write(reinterpret_cast<const char*>(piece.data()), static_cast<std::streamsize>(piece.size()));
+            if (!stream_) {
+                throw std::runtime_error("unable to write capture file");
+            }
+            continue;
+        }
+
+        staged_.insert(staged_.end(), piece.begin(), piece.end());
+        if (staged_.size() >= kStageSize) {
+            flush_locked();
+        }
+    } while (!payload.empty());
+}
+
+void CaptureWriter::flush() {
+    std::scoped_lock lock(mutex_);
+    flush_locked();
+    stream_.flush();
+}
+
+void CaptureWriter::flush_locked() {
+    stream_.write(reinterpret_cast<const char*>(staged_.data()), static_cast<std::streamsize>(staged_.size()));
+    staged_.clear();
+    if (!stream_) {
+        throw std::runtime_error("unable to write capture file");
+    }
+}
+
+CaptureReader::CaptureReader(const std::filesystem::path& path)
+    : file_(MappedFile::open(path)) {
+    const std::span<const std::byte> bytes = file_.bytes();
+    if (bytes.size() < kMagic.size() || std::memcmp(bytes.data(), kMagic.data(), kMagic.size()) != 0) {
+        throw std::runtime_error("not a pipetool capture: " + path.string());
+    }
+    offset_ = kMagic.size();
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+    const std::span<const std::byte> bytes = file_.bytes();
+    if (offset_ == bytes.size()) {
+        return false;
+    }
+    if (bytes.size() - offset_ < kHeaderSize) {
+        throw std::runtime_error("capture is truncated");
+    }
+
+    const std::byte* header = bytes.data() + offset_;
+    const std::size_t length = load_le<std::uint32_t>(header + 8);
+    if (bytes.size() - offset_ - kHeaderSize < length) {
+        throw std::runtime_error("capture is truncated");
+    }
+    if (header[18] != static_cast<std::byte>(CaptureDirection::sent) && header[18] != static_cast<std::byte>(CaptureDirection::received)) {
+        throw std::runtime_error("capture is corrupt: bad direction");
+    }
+
+    record.timestamp = std::chrono::nanoseconds {load_le<std::uint64_t>(header)};
+    record.error = static_cast<DWORD>(load_le<std::uint32_t>(header + 12));
+    record.connection = load_le<std::uint16_t>(header + 16);
+    record.direction = static_cast<CaptureDirection>(header[18]);
+    record.payload = bytes.subspan(offset_ + kHeaderSize, length);
+
+    offset_ += kHeaderSize + length;
+    return true;
+}
+
+} // namespace pipetool
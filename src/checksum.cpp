@@ -0,0 +1,161 @@
+#include "pipetool/checksum.hpp"
+
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <nmmintrin.h>
+#define PIPETOOL_CRC32C_X86 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <nmmintrin.h>
+#define PIPETOOL_CRC32C_X86 1
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define PIPETOOL_CRC32C_ARM 1
+#endif
+
+namespace pipetool {
+namespace {
+
+constexpr std::uint32_t kPolynomial = 0x82F63B78u; // reflected 0x1EDC6F41
+
+using Tables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+constexpr Tables make_tables() {
+    Tables tables {};
+    for (std::uint32_t index = 0; index < 256; ++index) {
+        std::uint32_t crc = index;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1u) != 0 ? kPolynomial : 0u);
+        }
+        tables[0][index] = crc;
+    }
+    for (std::size_t slice = 1; slice < tables.size(); ++slice) {
+        for (std::size_t index = 0; index < 256; ++index) {
+            const std::uint32_t previous = tables[slice - 1][index];
+            tables[slice][index] = (previous >> 8) ^ tables[0][previous & 0xFFu];
+        }
+    }
+    return tables;
+}
+
+constexpr Tables kTables = make_tables();
+
+std::uint64_t load_le64(const std::byte* data) noexcept {
+    std::uint64_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) {
+        value = std::byteswap(value);
+    }
+    return value;
+}
+
+// Takes and returns the register value, without the pre and post inversion.
+std::uint32_t update_portable(std::uint32_t crc, const std::byte* data, std::size_t size) noexcept {
+    while (size >= 8) {
+        const std::uint64_t word = load_le64(data) ^ crc;
+        crc = kTables[7][word & 0xFFu] ^ kTables[6][(word >> 8) & 0xFFu] ^ kTables[5][(word >> 16) & 0xFFu] ^ kTables[4][(word >> 24) & 0xFFu]
+            ^ kTables[3][(word >> 32) & 0xFFu] ^ kTables[2][(word >> 40) & 0xFFu] ^ kTables[1][(word >> 48) & 0xFFu] ^ kTables[0][word >> 56];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ kTables[0][(crc ^ static_cast<std::uint32_t>(*data++)) & 0xFFu];
+    }
+    return crc;
+}
+
+#if defined(PIPETOOL_CRC32C_X86)
+
+#if defined(_MSC_VER)
+bool detect_hardware() noexcept {
+    int registers[4] {};
+    __cpuid(registers, 1);
+    return (registers[2] & (1 << 20)) != 0;
+}
+#define PIPETOOL_TARGET_SSE42
+#else
+bool detect_hardware() noexcept {
+    // Runs during static initialisation, possibly before the CPU model is set up.
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+#define PIPETOOL_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+
+PIPETOOL_TARGET_SSE42 std::uint32_t update_hardware(std::uint32_t crc, const std::byte* data, std::size_t size) noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+    std::uint64_t wide = crc;
+    while (size >= 8) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+        data += 8;
+        size -= 8;
+    }
+    crc = static_cast<std::uint32_t>(wide);
+#endif
+    while (size >= 4) {
+        std::uint32_t word = 0;
+        std::memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+        data += 4;
+        size -= 4;
+    }
+    while (size-- > 0) {
+        crc = _mm_crc32_u8(crc, static_cast<std::uint8_t>(*data++));
+    }
+    return crc;
+}
+
+#elif defined(PIPETOOL_CRC32C_ARM)
+
+bool detect_hardware() noexcept {
+    return true;
+}
+
+std::uint32_t update_hardware(std::uint32_t crc, const std::byte* data, std::size_t size) noexcept {
+    while (size >= 8) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = __crc32cb(crc, static_cast<std::uint8_t>(*data++));
+    }
+    return crc;
+}
+
+#else
+
+bool detect_hardware() noexcept {
+    return false;
+}
+
+std::uint32_t update_hardware(std::uint32_t crc, const std::byte* data, std::size_t size) noexcept {
+    return update_portable(crc, data, size);
+}
+
+#endif
+
+const bool kHasHardware = detect_hardware();
+
+} // namespace
+
+std::uint32_t crc32c(std::span<const std::byte> data, std::uint32_t crc) noexcept {
+    return kHasHardware ? ~update_hardware(~crc, data.data(), data.size()) : ~update_portable(~crc, data.data(), data.size());
+}
+
+std::uint32_t crc32c_portable(std::span<const std::byte> data, std::uint32_t crc) noexcept {
+    return ~update_portable(~crc, data.data(), data.size());
+}
+
+bool crc32c_is_hardware() noexcept {
+    return kHasHardware;
+}
+
+} // namespace pipetool
@@ -0,0 +1,188 @@
+#include "pipetool/chunked_reader.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace pipetool {
+namespace {
+
+[[noreturn]] void throw_last_error(std::string_view context) {
+#if defined(_WIN32)
+    const int error = static_cast<int>(::GetLastError());
+#else
+    const int error = errno;
+#endif
+    throw std::system_error(error, std::system_category(), std::string(context));
+}
+
+HANDLE open_for_read(const std::filesystem::path& path) {
+#if defined(_WIN32)
+    HANDLE handle = ::CreateFileW(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        throw_last_error("CreateFileW");
+    }
+#else
+    const HANDLE handle = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (handle < 0) {
+        throw_last_error("open");
+    }
+    ::posix_fadvise(handle, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return handle;
+}
+
+} // namespace
+
+ChunkedFileReader::ChunkedFileReader(const std::filesystem::path& path, std::size_t chunk_size, std::size_t read_ahead) {
+    if (chunk_size == 0) {
+        throw std::invalid_argument("chunk size must be greater than zero");
+    }
+    handle_ = open_for_read(path);
+    start(chunk_size, read_ahead);
+}
+
+ChunkedFileReader::ChunkedFileReader(HANDLE handle, std::size_t chunk_size, std::size_t read_ahead)
+    : handle_(handle), owns_handle_(false) {
+    if (chunk_size == 0) {
+        throw std::invalid_argument("chunk size must be greater than zero");
+    }
+    start(chunk_size, read_ahead);
+}
+
+void ChunkedFileReader::start(std::size_t chunk_size, std::size_t read_ahead) {
+    buffers_.resize(read_ahead + 1);
+    for (auto& buffer : buffers_) {
+        buffer.resize(chunk_size);
+    }
+    sizes_.resize(buffers_.size());
+
+    if (read_ahead > 0) {
+        worker_ = std::jthread([this](std::stop_token stop) { fill_loop(stop); });
+    }
+}
+
+ChunkedFileReader::~ChunkedFileReader() {
+    if (worker_.joinable()) {
+        worker_.request_stop();
+        worker_.join();
+    }
+    if (!owns_handle_) {
+        return;
+    }
+#if defined(_WIN32)
+    ::CloseHandle(handle_);
+#else
+    ::close(handle_);
+#endif
+}
+
+std::span<const std::byte> ChunkedFileReader::next() {
+    if (!worker_.joinable()) {
+        const std::size_t bytes = read_chunk(buffers_.front());
+        return {buffers_.front().data(), bytes};
+    }
+
+    const std::size_t count = buffers_.size();
+    std::unique_lock lock {mutex_};
+    if (in_use_) {
+        head_ = (head_ + 1) % count;
+        in_use_ = false;
+        changed_.notify_all();
+    }
+
+    changed_.wait(lock, [this] { return ready_ > 0 || end_of_file_; });
+    if (ready_ > 0) {
+        --ready_;
+        in_use_ = true;
+        return {buffers_[head_].data(), sizes_[head_]};
+    }
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+    return {};
+}
+
+std::size_t ChunkedFileReader::read_chunk(std::span<std::byte> buffer) {
+#if defined(_WIN32)
+    const DWORD request = static_cast<DWORD>(std::min<std::size_t>(buffer.size(), std::numeric_limits<DWORD>::max()));
+    DWORD read = 0;
+    if (!::ReadFile(handle_, buffer.data(), request, &read, nullptr)) {
+        const DWORD error = ::GetLastError();
+        if (error == ERROR_HANDLE_EOF || error == ERROR_BROKEN_PIPE) {
+            return 0;
+        }
+        throw std::system_error(static_cast<int>(error), std::system_category(), "ReadFile");
+    }
+    return read;
+#else
+    while (true) {
+        const ssize_t read = ::read(handle_, buffer.data(), buffer.size());
+        if (read >= 0) {
+            return static_cast<std::size_t>(read);
+        }
+        if (errno != EINTR) {
+            throw_last_error("read");
+        }
+    }
+#endif
+}
+
+void ChunkedFileReader::fill_loop(std::stop_token stop) {
+    const std::size_t count = buffers_.size();
+
+    while (true) {
+        // The slot after the last filled one cannot move while we read into it:
+        // consuming a chunk and releasing the previous one keep
+        // head_ + ready_ + in_use_ unchanged.
+        std::size_t index = 0;
+        {
+            std::unique_lock lock {mutex_};
+            const bool has_free_slot = changed_.wait(lock, stop, [this, count] {
+                return ready_ + (in_use_ ? 1 : 0) < count;
+            });
+            if (!has_free_slot) {
+                return;
+            }
+            index = (head_ + ready_ + (in_use_ ? 1 : 0)) % count;
+        }
+
+        std::size_t bytes = 0;
+        try {
+            bytes = read_chunk(buffers_[index]);
+        } catch (...) {
+            const std::lock_guard lock {mutex_};
+            error_ = std::current_exception();
+            end_of_file_ = true;
+            changed_.notify_all();
+            return;
+        }
+
+        const std::lock_guard lock {mutex_};
+        if (bytes == 0) {
+            end_of_file_ = true;
+            changed_.notify_all();
+            return;
+        }
+        sizes_[index] = bytes;
+        ++ready_;
+        changed_.notify_all();
+    }
+}
+
+} // namespace pipetool
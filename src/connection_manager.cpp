@@ -0,0 +1,126 @@
+#include "pipetool/connection_manager.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+namespace pipetool {
+namespace {
+
+constexpr std::chrono::milliseconds kMinimumAttempt {1};
+
+// Uniform in [0, 1).
+double unit_interval(PayloadGenerator& random) {
+    return static_cast<double>(random.next() >> 11) * 0x1.0p-53;
+}
+
+} // namespace
+
+ConnectionManager::ConnectionManager(std::wstring pipe_name, DWORD desired_access, DWORD flags_and_attributes, const ReconnectPolicy& policy,
+    std::uint64_t seed, FailureHandler on_failure)
+    : pipe_name_(std::move(pipe_name)),
+      desired_access_(desired_access),
+      flags_and_attributes_(flags_and_attributes),
+      policy_(policy),
+      on_failure_(std::move(on_failure)),
+      random_(seed) {
+    if (policy_.standby > 0) {
+        filler_ = std::jthread([this, seed](std::stop_token stop) {
+            PayloadGenerator random {PayloadGenerator::derive_seed(seed, 1)};
+            while (!stop.stop_requested()) {
+                {
+                    std::unique_lock lock(mutex_);
+                    if (!changed_.wait(lock, stop, [this] { return standby_.size() < policy_.standby; })) {
+                        return;
+                    }
+                }
+                // Standby connections are not bound by the reconnect deadline.
+                PipeClient pipe = connect_with_backoff(stop, random, false);
+                if (pipe.is_valid()) {
+                    std::scoped_lock lock(mutex_);
+                    standby_.push_back(std::move(pipe));
+                }
+            }
+        });
+    }
+}
+
+ConnectionManager::~ConnectionManager() = default;
+
+PipeClient ConnectionManager::connect(std::stop_token stop) {
+    return connect_with_backoff(stop, random_, true);
+}
+
+PipeClient ConnectionManager::reconnect(std::stop_token stop) {
+    const auto started = std::chrono::steady_clock::now();
+    PipeClient pipe = take_standby();
+    if (!pipe.is_valid()) {
+        pipe = connect_with_backoff(stop, random_, true);
+    }
+
+    std::scoped_lock lock(mutex_);
+    ++reconnects_;
+    time_reconnecting_ += std::chrono::steady_clock::now() - started;
+    return pipe;
+}
+
+std::uint64_t ConnectionManager::reconnects() const {
+    std::scoped_lock lock(mutex_);
+    return reconnects_;
+}
+
+std::chrono::nanoseconds ConnectionManager::time_reconnecting() const {
+    std::scoped_lock lock(mutex_);
+    return time_reconnecting_;
+}
+
+PipeClient ConnectionManager::connect_with_backoff(const std::stop_token& stop, PayloadGenerator& random, bool bounded) {
+    std::optional<std::chrono::steady_clock::time_point> give_up;
+    if (bounded && policy_.deadline.count() > 0) {
+        give_up = std::chrono::steady_clock::now() + policy_.deadline;
+    }
+
+    std::chrono::duration<double, std::milli> delay = policy_.initial_delay;
+    while (!stop.stop_requested()) {
+        auto attempt = policy_.max_delay;
+        if (give_up) {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(*give_up - std::chrono::steady_clock::now());
+            attempt = std::min(attempt, remaining);
+        }
+        try {
+            return PipeClient::connect(pipe_name_, desired_access_, 0, flags_and_attributes_, std::max(attempt, kMinimumAttempt));
+        } catch (const std::system_error& ex) {
+            if (on_failure_) {
+                on_failure_(ex);
+            }
+        }
+
+        const auto wait = std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay * (1.0 - policy_.jitter * unit_interval(random)));
+        if (give_up && std::chrono::steady_clock::now() + wait >= *give_up) {
+            break;
+        }
+        {
+            // Sleeps on the condition variable so a stop request cuts it short.
+            std::unique_lock lock(mutex_);
+            changed_.wait_for(lock, stop, wait, [] { return false; });
+        }
+        delay = std::min<std::chrono::duration<double, std::milli>>(delay * policy_.multiplier, policy_.max_delay);
+    }
+    return PipeClient {};
+}
+
+// Hands over the oldest standby connection the server has not dropped.
+PipeClient ConnectionManager::take_standby() {
+    std::unique_lock lock(mutex_);
+    while (!standby_.empty()) {
+        PipeClient pipe = std::move(standby_.front());
+        standby_.pop_front();
+        changed_.notify_all();
+        if (pipe.peek().error == ERROR_SUCCESS) {
+            return pipe;
+        }
+    }
+    return PipeClient {};
+}
+
+} // namespace pipetool
@@ -0,0 +1,219 @@
+#include "pipetool/corpus.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace pipetool {
+namespace {
+
+constexpr std::array<std::uint32_t, 5> kInteresting8 {0x00, 0x01, 0x7F, 0x80, 0xFF};
+constexpr std::array<std::uint32_t, 7> kInteresting16 {0x0000, 0x0001, 0x00FF, 0x0100, 0x7FFF, 0x8000, 0xFFFF};
+constexpr std::array<std::uint32_t, 7> kInteresting32 {
+    0x00000000, 0x00000001, 0x0000FFFF, 0x00010000, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF};
+
+// FNV-1a; only used to recognise inputs the corpus already holds.
+std::uint64_t hash_bytes(std::span<const std::byte> bytes) noexcept {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (const std::byte value : bytes) {
+        hash = (hash ^ static_cast<std::uint64_t>(value)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::vector<std::byte> read_entry(const std::filesystem::path& path) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        throw std::runtime_error("unable to open corpus file " + path.string());
+    }
+    std::vector<std::byte> bytes(static_cast<std::size_t>(std::filesystem::file_size(path)));
+    stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!stream) {
+        throw std::runtime_error("unable to read corpus file " + path.string());
+    }
+    return bytes;
+}
+
+} // namespace
+
+Corpus::Corpus(const std::filesystem::path& directory)
+    : directory_(directory) {
+    std::filesystem::create_directories(directory_);
+
+    for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        std::vector<std::byte> bytes = read_entry(entry.path());
+        if (!hashes_.insert(hash_bytes(bytes)).second) {
+            continue;
+        }
+        largest_ = std::max(largest_, bytes.size());
+        entries_.push_back(std::move(bytes));
+    }
+}
+
+std::size_t Corpus::size() const {
+    std::shared_lock lock(mutex_);
+    return entries_.size();
+}
+
+std::size_t Corpus::largest() const {
+    std::shared_lock lock(mutex_);
+    return largest_;
+}
+
+std::size_t Corpus::entry_size(std::size_t index) const {
+    std::shared_lock lock(mutex_);
+    return entries_[index].size();
+}
+
+std::size_t Corpus::copy(std::size_t index, std::size_t offset, std::span<std::byte> out) const {
+    std::shared_lock lock(mutex_);
+    const std::vector<std::byte>& entry = entries_[index];
+    if (offset >= entry.size()) {
+        return 0;
+    }
+    const std::size_t count = std::min(out.size(), entry.size() - offset);
+    std::memcpy(out.data(), entry.data() + offset, count);
+    return count;
+}
+
+bool Corpus::add(std::span<const std::byte> input) {
+    const std::uint64_t hash = hash_bytes(input);
+    {
+        std::unique_lock lock(mutex_);
+        if (!hashes_.insert(hash).second) {
+            return false;
+        }
+        entries_.emplace_back(input.begin(), input.end());
+        largest_ = std::max(largest_, input.size());
+    }
+
+    std::ostringstream name;
+    name << "fault-" << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    std::ofstream stream(directory_ / name.str(), std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(input.data()), static_cast<std::streamsize>(input.size()));
+    if (!stream) {
+        throw std::runtime_error("unable to write corpus file " + (directory_ / name.str()).string());
+    }
+    return true;
+}
+
+Mutator::Mutator(const Corpus& corpus, std::uint64_t seed) noexcept
+    : corpus_(corpus), random_(seed) {}
+
+std::size_t Mutator::next(std::span<std::byte> buffer) {
+    if (buffer.empty()) {
+        return 0;
+    }
+
+    std::size_t size = 0;
+    const std::size_t count = corpus_.size();
+    if (count != 0) {
+        size = corpus_.copy(random_.uniform(0, count - 1), 0, buffer);
+    }
+    if (size == 0) {
+        size = random_.uniform(1, buffer.size());
+        random_.fill(buffer.first(size));
+    }
+
+    // Stack 1, 2, 4 or 8 mutations, so most inputs stay close to their seed.
+    const std::size_t rounds = std::size_t {1} << random_.uniform(0, 3);
+    for (std::size_t round = 0; round < rounds; ++round) {
+        size = mutate(buffer, size);
+    }
+    return size;
+}
+
+// Applies one mutation to buffer[0, size) and returns the new size, which is
+// always between 1 and buffer.size(). Mutations that cannot apply to the
+// current input fall back to a bit flip.
+std::size_t Mutator::mutate(std::span<std::byte> buffer, std::size_t size) {
+    std::byte* data = buffer.data();
+
+    switch (random_.uniform(0, 5)) {
+    case 1: {
+        // Substitute a byte with a guaranteed different value.
+        const std::size_t position = random_.uniform(0, size - 1);
+        data[position] ^= static_cast<std::byte>(random_.uniform(1, 255));
+        return size;
+    }
+    case 2: {
+        // Overwrite with a boundary value, in either byte order.
+        std::size_t width = std::size_t {1} << random_.uniform(0, 2);
+        if (width > size) {
+            width = 1;
+        }
+        std::uint32_t value = 0;
+        if (width == 1) {
+            value = kInteresting8[random_.uniform(0, kInteresting8.size() - 1)];
+        } else if (width == 2) {
+            value = kInteresting16[random_.uniform(0, kInteresting16.size() - 1)];
+        } else {
+            value = kInteresting32[random_.uniform(0, kInteresting32.size() - 1)];
+        }
+        const bool big_endian = (random_.next() & 1) != 0;
+        const std::size_t position = random_.uniform(0, size - width);
+        for (std::size_t index = 0; index < width; ++index) {
+            const std::size_t shift = 8 * (big_endian ? width - 1 - index : index);
+            data[position + index] = static_cast<std::byte>(value >> shift);
+        }
+        return size;
+    }
+    case 3: {
+        // Duplicate a block, inserting the copy at a random point.
+        if (size >= buffer.size()) {
+            break;
+        }
+        const std::size_t length = random_.uniform(1, std::min(size, buffer.size() - size));
+        const std::size_t source = random_.uniform(0, size - length);
+        const std::size_t target = random_.uniform(0, size);
+        std::memmove(data + target + length, data + target, size - target);
+        // Source bytes at or after the insertion point moved up by `length`.
+        for (std::size_t index = 0; index < length; ++index) {
+            const std::size_t from = source + index;
+            data[target + index] = data[from < target ? from : from + length];
+        }
+        return size + length;
+    }
+    case 4: {
+        // Delete a block, keeping at least one byte.
+        if (size < 2) {
+            break;
+        }
+        const std::size_t length = random_.uniform(1, size - 1);
+        const std::size_t position = random_.uniform(0, size - length);
+        std::memmove(data + position, data + position + length, size - position - length);
+        return size - length;
+    }
+    case 5: {
+        // Keep a prefix of this input and splice in the tail of another entry.
+        const std::size_t count = corpus_.size();
+        if (count == 0) {
+            break;
+        }
+        const std::size_t other = random_.uniform(0, count - 1);
+        const std::size_t other_size = corpus_.entry_size(other);
+        if (other_size == 0) {
+            break;
+        }
+        const std::size_t cut = random_.uniform(0, std::min(size, buffer.size() - 1));
+        const std::size_t offset = random_.uniform(0, other_size - 1);
+        return cut + corpus_.copy(other, offset, buffer.subspan(cut));
+    }
+    default:
+        break;
+    }
+
+    const std::size_t position = random_.uniform(0, size - 1);
+    data[position] ^= static_cast<std::byte>(1u << random_.uniform(0, 7));
+    return size;
+}
+
+} // namespace pipetool
@@ -1,87 +1,611 @@
 #include "pipetool/file_sender.hpp"
 
+#include "pipetool/async_pipe.hpp"
+#include "pipetool/capture.hpp"
+#include "pipetool/chunked_reader.hpp"
+#include "pipetool/file_sequence.hpp"
+#include "pipetool/framing.hpp"
 #include "pipetool/logging.hpp"
+#include "pipetool/mapped_file.hpp"
+#include "pipetool/message_reader.hpp"
 #include "pipetool/pipe_client.hpp"
+#include "pipetool/response_matcher.hpp"
+#include "pipetool/stream_verifier.hpp"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <mutex>
+#include <optional>
 #include <span>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <system_error>
+#include <thread>
+#include <utility>
 #include <vector>
 
-#include <windows.h>
+#include "pipetool/platform.hpp"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace pipetool {
 namespace {
 
+constexpr wchar_t kStandardInputPath[] = L"-";
+
+// How a source can reach the pipe without passing through user space.
+enum class ZeroCopy {
+    none,
+    splice,   // the source is a pipe or FIFO
+    sendfile, // the source is a regular file
+};
+
+HANDLE standard_input() {
+#if defined(_WIN32)
+    return ::GetStdHandle(STD_INPUT_HANDLE);
+#else
+    return STDIN_FILENO;
+#endif
+}
+
+#if defined(_WIN32)
+
+ZeroCopy zero_copy_method(HANDLE) {
+    return ZeroCopy::none;
+}
+
+std::optional<std::uint64_t> forward_zero_copy(HANDLE, ZeroCopy, const PipeClient&, std::size_t) {
+    return std::nullopt;
+}
+
+#else
+
+// splice() needs a pipe on one side and sendfile() a regular file as its
+// source; terminals and sockets go through the copy loop.
+ZeroCopy zero_copy_method(HANDLE source) {
+    struct stat info {};
+    if (::fstat(source, &info) != 0) {
+        return ZeroCopy::none;
+    }
+    if (S_ISFIFO(info.st_mode)) {
+        return ZeroCopy::splice;
+    }
+    if (S_ISREG(info.st_mode)) {
+        return ZeroCopy::sendfile;
+    }
+    return ZeroCopy::none;
+}
+
+// Moves the source into the pipe until it ends, inside the kernel. Returns
+// nullopt, having moved nothing, if the kernel refuses this pair of descriptors.
+std::optional<std::uint64_t> forward_zero_copy(HANDLE source, ZeroCopy method, const PipeClient& pipe, std::size_t chunk_size) {
+    std::uint64_t sent = 0;
+    while (true) {
+        const ssize_t moved = method == ZeroCopy::splice
+            ? ::splice(source, nullptr, pipe.native_handle(), nullptr, chunk_size, SPLICE_F_MOVE | SPLICE_F_MORE)
+            : ::sendfile(pipe.native_handle(), source, nullptr, chunk_size);
+        if (moved > 0) {
+            sent += static_cast<std::uint64_t>(moved);
+            continue;
+        }
+        if (moved == 0) {
+            return sent;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (sent == 0 && (errno == EINVAL || errno == ENOSYS)) {
+            return std::nullopt;
+        }
+        throw std::system_error(errno, std::system_category(), method == ZeroCopy::splice ? "splice" : "sendfile");
+    }
+}
+
+#endif
+
 void log_error(const std::wstring& message, DWORD error) {
     logging::log_message(message, error);
 }
 
+void record(CaptureWriter* capture, CaptureDirection direction, DWORD error, std::span<const std::byte> payload) {
+    if (capture != nullptr) {
+        capture->record(direction, 0, error, payload);
+    }
+}
+
+template <typename Writer>
+std::uint64_t send_chunked(Writer&& write, ChunkedFileReader& reader) {
+    std::uint64_t sent = 0;
+    for (auto chunk = reader.next(); !chunk.empty(); chunk = reader.next()) {
+        write(chunk);
+        sent += chunk.size();
+    }
+    return sent;
+}
+
+// Chunks are released from the working set once `release_lag` later chunks
+// have been handed to the writer, i.e. once they can no longer be in flight.
+// Without a lag nothing is released, for mappings other writers still read.
+template <typename Writer>
+std::uint64_t send_mapped(Writer&& write, const MappedFile& file, std::span<const std::byte> bytes, const StreamOptions& options, std::optional<std::size_t> release_lag) {
+    const std::size_t window = options.chunk_size * std::max<std::size_t>(options.read_ahead, 1);
+    const std::size_t lag_bytes = options.chunk_size * release_lag.value_or(0);
+
+    file.prefetch(bytes.first(std::min(window, bytes.size())));
+    for (std::size_t offset = 0; offset < bytes.size(); offset += options.chunk_size) {
+        const auto chunk = bytes.subspan(offset, std::min(options.chunk_size, bytes.size() - offset));
+
+        const std::size_t ahead = offset + chunk.size();
+        if (options.read_ahead > 0 && ahead < bytes.size()) {
+            file.prefetch(bytes.subspan(ahead, std::min(window, bytes.size() - ahead)));
+        }
+
+        write(chunk);
+        if (release_lag && offset >= lag_bytes) {
+            const std::size_t done = offset - lag_bytes;
+            file.release(bytes.subspan(done, std::min(options.chunk_size, bytes.size() - done)));
+        }
+    }
+    return bytes.size();
+}
+
+int report_closed(DWORD error) {
+    if (error == ERROR_SUCCESS) {
+        return EXIT_SUCCESS;
+    }
+    if (error == ERROR_BROKEN_PIPE || error == ERROR_PIPE_NOT_CONNECTED) {
+        log_error(L"Pipe connection closed", error);
+        return EXIT_SUCCESS;
+    }
+    log_error(L"Pipe read error", error);
+    return static_cast<int>(error);
+}
+
+int drain_responses(const PipeClient& pipe, CaptureWriter* capture) {
+    MessageReader reader {pipe};
+    while (true) {
+        const auto message = reader.next();
+        record(capture, CaptureDirection::received, message.error, message.data);
+        if (message.error != ERROR_SUCCESS) {
+            return report_closed(message.error);
+        }
+        if (message.data.empty()) {
+            return EXIT_SUCCESS;
+        }
+        logging::log_message(L"Pipe response", ERROR_SUCCESS, message.data);
+    }
+}
+
+constexpr std::size_t kResponseBufferSize = 64 * 1024;
+
+#if defined(_WIN32)
+// Message-mode pipes keep each write as one message, so chunks go out whole.
+constexpr std::size_t kInterleaveSlice = SIZE_MAX;
+#else
+// Byte streams have no boundaries to keep, so blocking writes are cut to a
+// size whose echo fits in the socket buffers until the next drain.
+constexpr std::size_t kInterleaveSlice = 64 * 1024;
+#endif
+
+// Logs the responses that have already arrived, without blocking, so a peer
+// that answers while the blocking writer is still sending never stalls on a
+// full pipe. Read failures are left for drain_responses to report.
+void log_available_responses(const PipeClient& pipe, CaptureWriter* capture, std::span<std::byte> buffer) {
+    while (true) {
+        const auto peeked = pipe.peek();
+        if (peeked.error != ERROR_SUCCESS || peeked.bytes_transferred == 0) {
+            return;
+        }
+        const auto result = pipe.read(buffer.first(std::min<std::size_t>(buffer.size(), peeked.bytes_transferred)));
+        const auto data = buffer.first(result.bytes_transferred);
+        record(capture, CaptureDirection::received, result.error, data);
+        if (result.error != ERROR_SUCCESS && result.error != ERROR_MORE_DATA) {
+            return;
+        }
+        logging::log_message(L"Pipe response", ERROR_SUCCESS, data);
+    }
+}
+
+std::wstring describe_transfer(std::wstring_view what, std::uint64_t bytes, std::chrono::steady_clock::duration elapsed, ZeroCopy method = ZeroCopy::none) {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    const double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+
+    std::wostringstream label;
+    label.setf(std::ios::fixed);
+    label.precision(1);
+    label << what << L": " << bytes << L" bytes in " << seconds * 1000.0 << L" ms";
+    if (seconds > 0.0) {
+        label << L" (" << megabytes / seconds << L" MB/s)";
+    }
+    if (method != ZeroCopy::none) {
+        label << (method == ZeroCopy::splice ? L" via splice" : L" via sendfile");
+    }
+    return label.str();
+}
+
+// Maps the file, reporting why not if it cannot be opened.
+std::optional<MappedFile> open_mapping(const std::filesystem::path& file_path) {
+    try {
+        return MappedFile::open(file_path);
+    } catch (const std::system_error& ex) {
+        std::wcerr << L"Unable to open file: " << file_path.wstring() << L"\n";
+        logging::log_system_error(L"Open failed", ex);
+        return std::nullopt;
+    }
+}
+
+// Stripes start on multiples of this, so each one maps and releases whole pages.
+constexpr std::size_t kStripeAlignment = 64 * 1024;
+constexpr std::size_t kStripeHeaderSize = 24;
+
+// Precedes each stripe's bytes: offset, length and file size, as
+// little-endian 64-bit integers.
+std::array<std::byte, kStripeHeaderSize> encode_stripe_header(std::uint64_t offset, std::uint64_t length, std::uint64_t file_size) {
+    std::array<std::byte, kStripeHeaderSize> header {};
+    const std::uint64_t fields[] = {offset, length, file_size};
+    for (std::size_t field = 0; field < std::size(fields); ++field) {
+        for (std::size_t index = 0; index < 8; ++index) {
+            header[field * 8 + index] = static_cast<std::byte>(fields[field] >> (8 * index));
+        }
+    }
+    return header;
+}
+
+// Sends byte ranges of one mapping concurrently, one connection per stripe.
+// Chunks are written straight from the mapping. Once a stripe fails the
+// others stop at their next chunk.
+int stream_striped(const std::wstring& pipe_name, const std::filesystem::path& file_path, const StreamOptions& options) {
+    const std::optional<MappedFile> mapping = open_mapping(file_path);
+    if (!mapping) {
+        return EXIT_FAILURE;
+    }
+    const MappedFile& file = *mapping;
+
+    const std::span<const std::byte> bytes = file.bytes();
+    const std::size_t per_stripe = (bytes.size() + options.stripes - 1) / options.stripes;
+    const std::size_t stripe_size = std::max<std::size_t>((per_stripe + kStripeAlignment - 1) / kStripeAlignment * kStripeAlignment, kStripeAlignment);
+    const std::size_t stripes = std::max<std::size_t>((bytes.size() + stripe_size - 1) / stripe_size, 1);
+
+    std::atomic<bool> failed {false};
+    std::atomic<int> status {EXIT_SUCCESS};
+    const auto started = std::chrono::steady_clock::now();
+    // When the last stripe finished writing, before responses are drained.
+    std::mutex finished_mutex;
+    auto finished = started;
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(stripes);
+        for (std::size_t stripe = 0; stripe < stripes; ++stripe) {
+            const std::size_t offset = stripe * stripe_size;
+            const auto range = bytes.subspan(offset, std::min(stripe_size, bytes.size() - offset));
+            workers.emplace_back([&, offset, range, stripe] {
+                try {
+                    PipeClient pipe = PipeClient::connect(pipe_name, GENERIC_WRITE | GENERIC_READ, 0, FILE_ATTRIBUTE_NORMAL);
+                    const auto header = encode_stripe_header(offset, range.size(), bytes.size());
+                    pipe.write(header);
+                    const auto write = [&pipe, &failed](std::span<const std::byte> chunk) {
+                        if (failed) {
+                            throw std::system_error(static_cast<int>(ERROR_OPERATION_ABORTED), std::system_category(), "another stripe failed");
+                        }
+                        pipe.write(chunk);
+                    };
+                    send_mapped(write, file, range, options, 0);
+                    {
+                        const std::lock_guard lock {finished_mutex};
+                        finished = std::max(finished, std::chrono::steady_clock::now());
+                    }
+                    if (const DWORD error = pipe.flush(); error != ERROR_SUCCESS) {
+                        log_error(L"FlushFileBuffers", error);
+                    }
+                    if (const int result = drain_responses(pipe, nullptr); result != EXIT_SUCCESS) {
+                        status = result;
+                    }
+                } catch (const std::system_error& ex) {
+                    if (!failed.exchange(true)) {
+                        logging::log_system_error(L"Stripe " + std::to_wstring(stripe) + L" failed", ex);
+                    }
+                    status = EXIT_FAILURE;
+                }
+            });
+        }
+    }
+
+    if (!failed) {
+        const std::wstring what = L"File sent in " + std::to_wstring(stripes) + L" stripes";
+        logging::log_message(describe_transfer(what, bytes.size(), finished - started), ERROR_SUCCESS);
+    }
+    return status;
+}
+
 } // namespace
 
-int stream_file(const std::wstring& pipe_name, const std::filesystem::path& file_path) {
+int stream_file(const std::wstring& pipe_name, const std::filesystem::path& file_path, const StreamOptions& options) {
     try {
-        std::ifstream input {file_path, std::ios::binary};
-        if (!input) {
-            std::wcerr << L"Unable to open file: " << file_path.wstring() << L"\n";
+        const bool from_stdin = file_path == kStandardInputPath;
+        if (options.stripes > 1) {
+            if (from_stdin || options.async_depth > 0 || !options.record_path.empty() || options.verify || !options.expect.path.empty()) {
+                std::wcerr << L"--stripes cannot be combined with standard input, --async, --record, --verify or --expect.\n";
+                return EXIT_FAILURE;
+            }
+            return stream_striped(pipe_name, file_path, options);
+        }
+        if (from_stdin && options.memory_map) {
+            std::wcerr << L"--mmap cannot read standard input.\n";
             return EXIT_FAILURE;
         }
+        if (options.verify && !options.expect.path.empty()) {
+            std::wcerr << L"--verify and --expect cannot be combined.\n";
+            return EXIT_FAILURE;
+        }
+        // Checking responses reads them while still writing, which needs the
+        // async engine: a blocking writer stalls once the peer's buffers fill.
+        const bool checked = options.verify || !options.expect.path.empty();
+        const std::size_t async_depth = checked ? std::max<std::size_t>(options.async_depth, 2) : options.async_depth;
+        // Captures and the async engine need the bytes in user space.
+        const bool can_zero_copy = from_stdin && !options.copy && async_depth == 0 && options.record_path.empty();
+        const ZeroCopy zero_copy = can_zero_copy ? zero_copy_method(standard_input()) : ZeroCopy::none;
+        // Standard input is read at least one chunk ahead, so the next read
+        // overlaps the current pipe write even with --read-ahead 0.
+        const std::size_t read_ahead = from_stdin ? std::max<std::size_t>(options.read_ahead, 1) : options.read_ahead;
 
-        PipeClient pipe = PipeClient::connect(pipe_name, GENERIC_WRITE | GENERIC_READ, 0, FILE_ATTRIBUTE_NORMAL);
-
-        input.seekg(0, std::ios::end);
-        const std::streamsize file_size = input.tellg();
-        if (file_size < 0) {
-            std::wcerr << L"Unable to determine file size: " << file_path.wstring() << L"\n";
+        // Open the source before connecting so a bad path never ties up a pipe
+        // instance. The reader for a zero-copy source is only created if the
+        // kernel turns the transfer down, as its worker would start consuming input.
+        std::optional<MappedFile> mapped;
+        std::optional<ChunkedFileReader> reader;
+        try {
+            if (options.memory_map) {
+                mapped.emplace(MappedFile::open(file_path));
+            } else if (!from_stdin) {
+                reader.emplace(file_path, options.chunk_size, read_ahead);
+            } else if (zero_copy == ZeroCopy::none) {
+                reader.emplace(standard_input(), options.chunk_size, read_ahead);
+            }
+        } catch (const std::system_error& ex) {
+            std::wcerr << L"Unable to open file: " << file_path.wstring() << L"\n";
+            logging::log_system_error(L"Open failed", ex);
             return EXIT_FAILURE;
         }
-        input.seekg(0, std::ios::beg);
 
-        std::vector<std::byte> buffer(static_cast<std::size_t>(file_size));
-        if (!input.read(reinterpret_cast<char*>(buffer.data()), file_size)) {
-            std::wcerr << L"Error while reading file: " << file_path.wstring() << L"\n";
+        std::optional<ResponseMatcher> matcher;
+        if (!open_expected(options.expect, matcher)) {
             return EXIT_FAILURE;
         }
 
-        pipe.write(std::span<const std::byte>(buffer.data(), buffer.size()));
-        logging::log_message(L"File sent", ERROR_SUCCESS);
+        std::optional<CaptureWriter> capture_file;
+        if (!options.record_path.empty()) {
+            capture_file.emplace(options.record_path);
+        }
+        CaptureWriter* capture = capture_file ? &*capture_file : nullptr;
+
+        const DWORD flags = async_depth > 0 ? FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED : FILE_ATTRIBUTE_NORMAL;
+        PipeClient pipe = PipeClient::connect(pipe_name, GENERIC_WRITE | GENERIC_READ, 0, flags);
+        const auto started = std::chrono::steady_clock::now();
+
+        if (async_depth > 0) {
+            // Responses are logged as they arrive, interleaved with the writes,
+            // unless they are being checked against what was sent or expected.
+            std::optional<StreamVerifier> verifier;
+            if (options.verify) {
+                verifier.emplace();
+            }
+            AsyncPipe engine {std::move(pipe), async_depth, options.chunk_size, [capture, &verifier, &matcher](std::span<const std::byte> data, DWORD error) {
+                if (verifier && error == ERROR_SUCCESS) {
+                    verifier->received(data);
+                } else if (matcher && error == ERROR_SUCCESS) {
+                    matcher->received(data);
+                } else {
+                    logging::log_message(L"Pipe response", error, data);
+                }
+                record(capture, CaptureDirection::received, error, data);
+            }};
+
+            const auto write_borrowed = [&engine, &verifier, capture](std::span<const std::byte> chunk) {
+                if (verifier) {
+                    verifier->sent(chunk);
+                }
+                engine.write_borrowed(chunk);
+                record(capture, CaptureDirection::sent, ERROR_SUCCESS, chunk);
+            };
+            const auto write_copy = [&engine, &verifier, capture](std::span<const std::byte> chunk) {
+                if (verifier) {
+                    verifier->sent(chunk);
+                }
+                engine.write(chunk);
+                record(capture, CaptureDirection::sent, ERROR_SUCCESS, chunk);
+            };
+            const std::uint64_t sent = mapped
+                ? send_mapped(write_borrowed, *mapped, mapped->bytes(), options, async_depth)
+                : send_chunked(write_copy, *reader);
+            engine.flush_writes();
+            logging::log_message(describe_transfer(L"File sent", sent, std::chrono::steady_clock::now() - started), ERROR_SUCCESS);
+
+            if (const DWORD error = engine.client().flush(); error != ERROR_SUCCESS) {
+                log_error(L"FlushFileBuffers", error);
+            }
+            const int status = report_closed(engine.run_until_closed());
+            if (capture != nullptr) {
+                capture->flush();
+            }
+            if ((verifier && !verifier->finish()) || (matcher && !matcher->finish())) {
+                return EXIT_FAILURE;
+            }
+            return status;
+        }
+
+        std::vector<std::byte> response_buffer(kResponseBufferSize);
+        const auto write = [&pipe, capture, &response_buffer](std::span<const std::byte> chunk) {
+            while (!chunk.empty()) {
+                const auto slice = chunk.first(std::min(chunk.size(), kInterleaveSlice));
+                pipe.write(slice);
+                record(capture, CaptureDirection::sent, ERROR_SUCCESS, slice);
+                chunk = chunk.subspan(slice.size());
+                log_available_responses(pipe, capture, response_buffer);
+            }
+        };
+        std::optional<std::uint64_t> sent;
+        if (zero_copy != ZeroCopy::none) {
+            sent = forward_zero_copy(standard_input(), zero_copy, pipe, options.chunk_size);
+            if (!sent) {
+                reader.emplace(standard_input(), options.chunk_size, read_ahead);
+            }
+        }
+        const ZeroCopy method = sent ? zero_copy : ZeroCopy::none;
+        if (!sent) {
+            sent = mapped ? send_mapped(write, *mapped, mapped->bytes(), options, 0) : send_chunked(write, *reader);
+        }
+        logging::log_message(describe_transfer(L"File sent", *sent, std::chrono::steady_clock::now() - started, method), ERROR_SUCCESS);
 
-        if (!::FlushFileBuffers(pipe.native_handle())) {
-            const DWORD error = ::GetLastError();
+        if (const DWORD error = pipe.flush(); error != ERROR_SUCCESS) {
             log_error(L"FlushFileBuffers", error);
         }
 
-        std::array<std::byte, 4096> response_buffer {};
-        while (true) {
-            const auto result = pipe.read(std::span<std::byte>(response_buffer.data(), response_buffer.size()));
-            if (result.error == ERROR_SUCCESS) {
-                if (result.bytes_transferred == 0) {
-                    break;
-                }
-                logging::log_message(L"Pipe response", ERROR_SUCCESS, std::span<const std::byte>(response_buffer.data(), result.bytes_transferred));
-                continue;
+        const int status = drain_responses(pipe, capture);
+        if (capture != nullptr) {
+            capture->flush();
+        }
+        return status;
+    } catch (const std::system_error& ex) {
+        logging::log_system_error(L"Stream failed", ex);
+        return EXIT_FAILURE;
+    } catch (const std::exception& ex) {
+        std::cerr << "Stream failed: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
+
+int broadcast_file(const std::vector<std::wstring>& pipe_names, const std::filesystem::path& file_path, const StreamOptions& options) {
+    if (pipe_names.empty()) {
+        std::wcerr << L"No pipes match.\n";
+        return EXIT_FAILURE;
+    }
+    if (file_path == kStandardInputPath || options.async_depth > 0 || options.stripes > 1 || !options.record_path.empty() || options.verify || !options.expect.path.empty()) {
+        std::wcerr << L"Several targets cannot be combined with standard input, --async, --stripes, --record, --verify or --expect.\n";
+        return EXIT_FAILURE;
+    }
+
+    try {
+        const std::optional<MappedFile> mapping = open_mapping(file_path);
+        if (!mapping) {
+            return EXIT_FAILURE;
+        }
+        const MappedFile& file = *mapping;
+
+        // Every target walks the one mapping at its own pace on its own thread,
+        // so a slow target only holds up itself and a failed one only ends itself.
+        std::atomic<int> status {EXIT_SUCCESS};
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(pipe_names.size());
+            for (const std::wstring& pipe_name : pipe_names) {
+                workers.emplace_back([&file, &options, &status, &pipe_name] {
+                    try {
+                        PipeClient pipe = PipeClient::connect(pipe_name, GENERIC_WRITE | GENERIC_READ, 0, FILE_ATTRIBUTE_NORMAL);
+                        const auto started = std::chrono::steady_clock::now();
+                        const auto write = [&pipe](std::span<const std::byte> chunk) { pipe.write(chunk); };
+                        const std::uint64_t sent = send_mapped(write, file, file.bytes(), options, std::nullopt);
+                        logging::log_message(describe_transfer(L"File sent to " + pipe.qualified_name(), sent, std::chrono::steady_clock::now() - started), ERROR_SUCCESS);
+
+                        if (const DWORD error = pipe.flush(); error != ERROR_SUCCESS) {
+                            log_error(L"FlushFileBuffers", error);
+                        }
+                        if (const int result = drain_responses(pipe, nullptr); result != EXIT_SUCCESS) {
+                            status = result;
+                        }
+                    } catch (const std::system_error& ex) {
+                        logging::log_system_error(L"Stream to " + pipe_name + L" failed", ex);
+                        status = EXIT_FAILURE;
+                    }
+                });
             }
+        }
+        return status;
+    } catch (const std::system_error& ex) {
+        logging::log_system_error(L"Stream failed", ex);
+        return EXIT_FAILURE;
+    } catch (const std::exception& ex) {
+        std::cerr << "Stream failed: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
+
+int stream_files(const std::wstring& pipe_name, const std::vector<std::filesystem::path>& files, const StreamOptions& options) {
+    // Responses are only read once every file is written, so a checked peer
+    // that answers in bulk would fill its buffers and stall the writes.
+    if (options.memory_map || options.async_depth > 0 || options.stripes > 1 || options.verify || !options.expect.path.empty()) {
+        std::wcerr << L"--mmap, --async, --stripes, --verify and --expect only apply to a single file.\n";
+        return EXIT_FAILURE;
+    }
+    if (options.framing.framing != Framing::raw && !options.record_path.empty()) {
+        std::wcerr << L"--record captures unframed streams only.\n";
+        return EXIT_FAILURE;
+    }
+    if (files.empty()) {
+        std::wcerr << L"No files to stream.\n";
+        return EXIT_FAILURE;
+    }
+
+    try {
+        std::optional<CaptureWriter> capture_file;
+        if (!options.record_path.empty()) {
+            capture_file.emplace(options.record_path);
+        }
+        CaptureWriter* capture = capture_file ? &*capture_file : nullptr;
+
+        // A framed file goes out as one frame, so the reader hands it over whole.
+        const bool framed = options.framing.framing != Framing::raw;
+        FileSequenceReader reader {files, options.chunk_size, options.read_ahead, framed};
 
-            if (result.error == ERROR_MORE_DATA) {
-                logging::log_message(L"Pipe response", ERROR_MORE_DATA, std::span<const std::byte>(response_buffer.data(), result.bytes_transferred));
+        PipeClient pipe = PipeClient::connect(pipe_name, GENERIC_WRITE | GENERIC_READ, 0, FILE_ATTRIBUTE_NORMAL);
+        FrameWriter writer {pipe, options.framing};
+        const auto started = std::chrono::steady_clock::now();
+
+        std::uint64_t sent = 0;
+        std::size_t skipped = 0;
+        while (const auto chunk = reader.next()) {
+            const std::wstring path = reader.path(chunk->file_index).wstring();
+            if (chunk->error) {
+                logging::log_message(L"Skipped " + path, static_cast<DWORD>(chunk->error.value()));
+                ++skipped;
                 continue;
             }
-
-            if (result.error == ERROR_BROKEN_PIPE || result.error == ERROR_PIPE_NOT_CONNECTED) {
-                log_error(L"Pipe connection closed", result.error);
-                break;
+            if (chunk->data.size() > options.framing.max_frame_size()) {
+                logging::log_message(L"Skipped " + path + L" (larger than a frame)", ERROR_SUCCESS);
+                ++skipped;
+                continue;
+            }
+            if (framed || !chunk->data.empty()) {
+                writer.write(chunk->data);
+                record(capture, CaptureDirection::sent, ERROR_SUCCESS, chunk->data);
+                sent += chunk->data.size();
             }
+        }
+        writer.flush();
+
+        const std::wstring what = std::to_wstring(files.size() - skipped) + L" of " + std::to_wstring(files.size()) + L" files sent";
+        logging::log_message(describe_transfer(what, sent, std::chrono::steady_clock::now() - started), ERROR_SUCCESS);
 
-            log_error(L"Pipe read error", result.error);
-            return static_cast<int>(result.error);
+        if (const DWORD error = pipe.flush(); error != ERROR_SUCCESS) {
+            log_error(L"FlushFileBuffers", error);
         }
 
-        return EXIT_SUCCESS;
+        const int status = drain_responses(pipe, capture);
+        if (capture != nullptr) {
+            capture->flush();
+        }
+        return skipped > 0 ? EXIT_FAILURE : status;
     } catch (const std::system_error& ex) {
         logging::log_system_error(L"Stream failed", ex);
         return EXIT_FAILURE;
@@ -0,0 +1,161 @@
+#include "pipetool/file_sequence.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace pipetool {
+namespace {
+
+// Reads until `bytes` is full or the file ends; returns the bytes read.
+std::size_t read_some(std::ifstream& stream, std::span<std::byte> bytes) {
+    stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<std::size_t>(stream.gcount());
+}
+
+} // namespace
+
+std::vector<std::filesystem::path> directory_files(const std::filesystem::path& directory) {
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::vector<std::filesystem::path> manifest_files(const std::filesystem::path& manifest) {
+    std::ifstream stream(manifest);
+    if (!stream) {
+        throw std::runtime_error("unable to open manifest " + manifest.string());
+    }
+
+    const std::filesystem::path base = manifest.parent_path();
+    std::vector<std::filesystem::path> files;
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        std::filesystem::path path = std::filesystem::u8path(line);
+        files.push_back(path.is_relative() ? base / path : std::move(path));
+    }
+    if (stream.bad()) {
+        throw std::runtime_error("unable to read manifest " + manifest.string());
+    }
+    return files;
+}
+
+FileSequenceReader::FileSequenceReader(std::vector<std::filesystem::path> files, std::size_t chunk_size, std::size_t read_ahead, bool whole_files)
+    : files_(std::move(files)),
+      chunk_size_(chunk_size),
+      read_ahead_(std::max<std::size_t>(read_ahead, 1)),
+      whole_files_(whole_files) {
+    if (chunk_size == 0) {
+        throw std::invalid_argument("chunk size must be greater than zero");
+    }
+    worker_ = std::jthread([this](const std::stop_token& stop) { read_loop(stop); });
+}
+
+std::optional<FileChunk> FileSequenceReader::next() {
+    std::unique_lock lock {mutex_};
+    if (current_) {
+        free_buffers_.push_back(std::move(current_->buffer));
+        current_.reset();
+        changed_.notify_all();
+    }
+
+    changed_.wait(lock, [this] { return !ready_.empty() || done_; });
+    if (ready_.empty()) {
+        return std::nullopt;
+    }
+    current_ = std::move(ready_.front());
+    ready_.pop_front();
+    changed_.notify_all();
+    return current_->chunk;
+}
+
+const std::filesystem::path& FileSequenceReader::path(std::size_t file_index) const {
+    return files_.at(file_index);
+}
+
+std::vector<std::byte> FileSequenceReader::take_buffer() {
+    const std::lock_guard lock {mutex_};
+    if (free_buffers_.empty()) {
+        return {};
+    }
+    std::vector<std::byte> buffer = std::move(free_buffers_.back());
+    free_buffers_.pop_back();
+    return buffer;
+}
+
+// Waits for room in the queue. Returns false if the reader is being destroyed.
+bool FileSequenceReader::publish(const std::stop_token& stop, Slot slot) {
+    std::unique_lock lock {mutex_};
+    if (!changed_.wait(lock, stop, [this] { return ready_.size() < read_ahead_; })) {
+        return false;
+    }
+    ready_.push_back(std::move(slot));
+    changed_.notify_all();
+    return true;
+}
+
+void FileSequenceReader::read_loop(const std::stop_token& stop) {
+    for (std::size_t index = 0; index < files_.size() && !stop.stop_requested(); ++index) {
+        Slot slot;
+        slot.chunk.file_index = index;
+        slot.chunk.first = true;
+
+        std::ifstream stream(files_[index], std::ios::binary);
+        std::error_code size_error;
+        const std::uintmax_t size = std::filesystem::file_size(files_[index], size_error);
+        if (!stream || size_error) {
+            slot.chunk.last = true;
+            slot.chunk.error = size_error ? size_error : std::make_error_code(std::errc::no_such_file_or_directory);
+            if (!publish(stop, std::move(slot))) {
+                return;
+            }
+            continue;
+        }
+
+        bool last = false;
+        while (!last) {
+            slot.buffer = take_buffer();
+            // A file that grew since it was sized is still sent whole: reading
+            // continues past the expected size until the stream ends.
+            slot.buffer.resize(whole_files_ ? static_cast<std::size_t>(size) + 1 : chunk_size_);
+            std::size_t bytes = read_some(stream, slot.buffer);
+            while (whole_files_ && bytes == slot.buffer.size()) {
+                slot.buffer.resize(slot.buffer.size() * 2);
+                bytes += read_some(stream, std::span<std::byte>(slot.buffer).subspan(bytes));
+            }
+            last = whole_files_ || bytes < slot.buffer.size() || stream.peek() == std::ifstream::traits_type::eof();
+            if (stream.bad()) {
+                slot.chunk.error = std::make_error_code(std::errc::io_error);
+                bytes = 0;
+                last = true;
+            }
+            slot.chunk.last = last;
+            slot.chunk.data = {slot.buffer.data(), bytes};
+            if (!publish(stop, std::move(slot))) {
+                return;
+            }
+            slot = Slot {};
+            slot.chunk.file_index = index;
+        }
+    }
+
+    const std::lock_guard lock {mutex_};
+    done_ = true;
+    changed_.notify_all();
+}
+
+} // namespace pipetool
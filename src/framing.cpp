@@ -0,0 +1,87 @@
+#include "pipetool/framing.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace pipetool {
+
+std::size_t FrameFormat::header_size() const noexcept {
+    return framing == Framing::length_prefixed ? prefix_size : 0;
+}
+
+std::size_t FrameFormat::max_frame_size() const noexcept {
+    if (framing != Framing::length_prefixed) {
+        return std::numeric_limits<std::size_t>::max();
+    }
+    return prefix_size == 2 ? std::numeric_limits<std::uint16_t>::max() : std::numeric_limits<std::uint32_t>::max();
+}
+
+bool parse_frame_format(std::wstring_view text, FrameFormat& format) {
+    if (text == L"raw") {
+        format = {Framing::raw};
+    } else if (text == L"message") {
+        format = {Framing::message};
+    } else if (text == L"u16le") {
+        format = {Framing::length_prefixed, 2, std::endian::little};
+    } else if (text == L"u16be") {
+        format = {Framing::length_prefixed, 2, std::endian::big};
+    } else if (text == L"u32le") {
+        format = {Framing::length_prefixed, 4, std::endian::little};
+    } else if (text == L"u32be") {
+        format = {Framing::length_prefixed, 4, std::endian::big};
+    } else {
+        return false;
+    }
+    return true;
+}
+
+FrameWriter::FrameWriter(const PipeClient& pipe, const FrameFormat& format, std::size_t batch_frames)
+    : pipe_(pipe),
+      format_(format),
+      batch_frames_(format.framing == Framing::message ? 1 : std::max<std::size_t>(batch_frames, 1)) {
+    headers_.resize(format_.header_size() * batch_frames_);
+    buffers_.reserve(2 * batch_frames_);
+}
+
+void FrameWriter::write(std::span<const std::byte> payload) {
+    if (payload.size() > format_.max_frame_size()) {
+        throw std::length_error("frame exceeds the length prefix");
+    }
+
+    const std::size_t header_size = format_.header_size();
+    if (header_size > 0) {
+        std::byte* header = headers_.data() + queued_ * header_size;
+        for (std::size_t index = 0; index < header_size; ++index) {
+            const std::size_t shift = 8 * (format_.byte_order == std::endian::little ? index : header_size - 1 - index);
+            header[index] = static_cast<std::byte>(payload.size() >> shift);
+        }
+        buffers_.emplace_back(header, header_size);
+    }
+    buffers_.push_back(payload);
+
+    if (++queued_ == batch_frames_) {
+        flush();
+    }
+}
+
+void FrameWriter::flush() {
+    if (queued_ == 0) {
+        return;
+    }
+    queued_ = 0;
+    try {
+        write_calls_ += buffers_.size() == 1 ? pipe_.write(buffers_.front()) : pipe_.write_gathered(buffers_);
+    } catch (...) {
+        // A failed batch is dropped rather than left borrowing stale payloads.
+        buffers_.clear();
+        throw;
+    }
+    buffers_.clear();
+}
+
+std::uint64_t FrameWriter::write_calls() const noexcept {
+    return write_calls_;
+}
+
+} // namespace pipetool
@@ -0,0 +1,148 @@
+#include "pipetool/latency_histogram.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <ios>
+#include <sstream>
+
+namespace pipetool {
+namespace {
+
+// The recording thread is the only writer, so a relaxed load and store is
+// enough; the atomic_ref only keeps concurrent snapshots free of torn reads.
+void bump(std::uint64_t& slot, std::uint64_t amount) noexcept {
+    std::atomic_ref<std::uint64_t> ref {slot};
+    ref.store(ref.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+std::uint64_t read(const std::uint64_t& slot) noexcept {
+    return std::atomic_ref<const std::uint64_t> {slot}.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+std::size_t LatencyHistogram::index_of(std::uint64_t value) noexcept {
+    if (value < kSubBuckets) {
+        return static_cast<std::size_t>(value);
+    }
+    const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - kSubBucketBits;
+    const std::uint64_t mantissa = value >> shift;
+    return (shift + 1) * kSubBuckets + static_cast<std::size_t>(mantissa - kSubBuckets);
+}
+
+std::uint64_t LatencyHistogram::highest_equivalent(std::size_t index) noexcept {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    const std::size_t shift = index / kSubBuckets - 1;
+    const std::uint64_t mantissa = kSubBuckets + index % kSubBuckets;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds value) noexcept {
+    const std::uint64_t nanoseconds = value.count() > 0 ? static_cast<std::uint64_t>(value.count()) : 0;
+    bump(counts_[index_of(nanoseconds)], 1);
+    bump(count_, 1);
+    bump(sum_, nanoseconds);
+    if (nanoseconds > max_) {
+        std::atomic_ref<std::uint64_t> {max_}.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram LatencyHistogram::snapshot() const noexcept {
+    LatencyHistogram copy;
+    for (std::size_t index = 0; index < kBucketCount; ++index) {
+        copy.counts_[index] = read(counts_[index]);
+    }
+    // Recomputed from the copied buckets so the total always matches them.
+    for (const std::uint64_t bucket : copy.counts_) {
+        copy.count_ += bucket;
+    }
+    copy.max_ = read(max_);
+    copy.sum_ = read(sum_);
+    return copy;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+    for (std::size_t index = 0; index < kBucketCount; ++index) {
+        counts_[index] += other.counts_[index];
+    }
+    count_ += other.count_;
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+void LatencyHistogram::subtract(const LatencyHistogram& earlier) noexcept {
+    max_ = 0;
+    count_ = 0;
+    sum_ -= std::min(sum_, earlier.sum_);
+    for (std::size_t index = 0; index < kBucketCount; ++index) {
+        counts_[index] -= std::min(counts_[index], earlier.counts_[index]);
+        if (counts_[index] != 0) {
+            count_ += counts_[index];
+            max_ = highest_equivalent(index);
+        }
+    }
+}
+
+std::uint64_t LatencyHistogram::count() const noexcept {
+    return count_;
+}
+
+std::chrono::nanoseconds LatencyHistogram::max() const noexcept {
+    return std::chrono::nanoseconds {static_cast<std::chrono::nanoseconds::rep>(max_)};
+}
+
+std::chrono::nanoseconds LatencyHistogram::mean() const noexcept {
+    if (count_ == 0) {
+        return std::chrono::nanoseconds {0};
+    }
+    return std::chrono::nanoseconds {static_cast<std::chrono::nanoseconds::rep>(sum_ / count_)};
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(double percentile) const noexcept {
+    if (count_ == 0) {
+        return std::chrono::nanoseconds {0};
+    }
+    const double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+    const auto target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count_))));
+
+    std::uint64_t seen = 0;
+    for (std::size_t index = 0; index < kBucketCount; ++index) {
+        seen += counts_[index];
+        if (seen >= target) {
+            // The bucket bound can overshoot the largest sample actually seen.
+            const std::uint64_t bound = std::min(highest_equivalent(index), max_);
+            return std::chrono::nanoseconds {static_cast<std::chrono::nanoseconds::rep>(bound)};
+        }
+    }
+    return max();
+}
+
+std::wstring describe_percentiles(const LatencyHistogram& histogram) {
+    // Sub-millisecond values read better in microseconds.
+    const auto append = [](std::wostringstream& text, std::chrono::nanoseconds value) {
+        if (value < std::chrono::milliseconds {1}) {
+            text.precision(1);
+            text << std::chrono::duration<double, std::micro>(value).count() << L" us";
+        } else {
+            text.precision(3);
+            text << std::chrono::duration<double, std::milli>(value).count() << L" ms";
+        }
+    };
+
+    std::wostringstream text;
+    for (const double percentile : kReportedPercentiles) {
+        text.precision(4);
+        text << L"p" << std::defaultfloat << percentile << std::fixed << L" ";
+        append(text, histogram.percentile(percentile));
+        text << L", ";
+    }
+    text << L"max ";
+    append(text, histogram.max());
+    return text.str();
+}
+
+} // namespace pipetool
@@ -1,18 +1,32 @@
 #include "pipetool/logging.hpp"
 
-#include <iomanip>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <thread>
 #include <vector>
 
+#if defined(_WIN32)
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace pipetool::logging {
 namespace {
 
+#if defined(_WIN32)
+
 class ConsoleColorScope {
 public:
     explicit ConsoleColorScope(bool success) {
@@ -46,6 +60,30 @@ private:
     WORD original_attributes_ {0};
 };
 
+#else
+
+class ConsoleColorScope {
+public:
+    explicit ConsoleColorScope(bool success) {
+        static const bool is_terminal = ::isatty(STDOUT_FILENO) != 0;
+        active_ = is_terminal;
+        if (active_) {
+            std::wcout << (success ? L"\x1b[92m" : L"\x1b[91m");
+        }
+    }
+
+    ~ConsoleColorScope() {
+        if (active_) {
+            std::wcout << L"\x1b[0m";
+        }
+    }
+
+private:
+    bool active_ {false};
+};
+
+#endif
+
 std::wstring sanitize_message(std::wstring_view message) {
     std::wstring clean {message};
     for (auto& ch : clean) {
@@ -56,76 +94,322 @@ std::wstring sanitize_message(std::wstring_view message) {
     return clean;
 }
 
-void write_hex_dump(std::span<const std::byte> payload) {
-    constexpr std::size_t kRowWidth = 16;
+struct DumpTables {
+    std::array<std::array<wchar_t, 2>, 256> hex {};
+    std::array<wchar_t, 256> text {};
+};
+
+constexpr DumpTables make_dump_tables() {
+    constexpr std::wstring_view kDigits = L"0123456789abcdef";
+    DumpTables tables;
+    for (std::size_t value = 0; value < 256; ++value) {
+        tables.hex[value] = {kDigits[value >> 4], kDigits[value & 0x0F]};
+        tables.text[value] = (value >= 32 && value <= 126) ? static_cast<wchar_t>(value) : L'.';
+    }
+    return tables;
+}
+
+constexpr DumpTables kDumpTables = make_dump_tables();
+
+constexpr std::size_t kDumpRowWidth = 16;
+constexpr std::size_t kDumpOffsetDigits = 6;
+// Indent, offset, gap, hex columns, separator, text column, terminator; the
+// offset may widen past six digits, so allow for a full 64-bit one.
+constexpr std::size_t kDumpMaxRowLength = 4 + 16 + 2 + kDumpRowWidth * 3 + 2 + kDumpRowWidth + 2;
+
+wchar_t* write_offset(wchar_t* cursor, std::size_t offset) {
+    std::size_t digits = kDumpOffsetDigits;
+    while (digits < sizeof(std::size_t) * 2 && (offset >> (digits * 4)) != 0) {
+        ++digits;
+    }
+    for (std::size_t index = digits; index-- > 0;) {
+        *cursor++ = L"0123456789abcdef"[(offset >> (index * 4)) & 0x0F];
+    }
+    return cursor;
+}
+
+std::size_t render_hex_dump(std::span<const std::byte> payload, wchar_t* out) {
     const std::size_t size = payload.size();
+    wchar_t* cursor = out;
 
-    for (std::size_t offset = 0; offset < size; offset += kRowWidth) {
-        std::wcout << L"    " << std::setw(6) << std::setfill(L'0') << std::hex << offset << L"  ";
+    for (std::size_t offset = 0; offset < size; offset += kDumpRowWidth) {
+        const std::size_t columns = std::min(kDumpRowWidth, size - offset);
+        const auto* row = reinterpret_cast<const unsigned char*>(payload.data() + offset);
 
-        std::wcout << std::dec << std::setfill(L' ');
-        for (std::size_t column = 0; column < kRowWidth; ++column) {
-            const std::size_t index = offset + column;
-            if (index < size) {
-                const auto byte_value = static_cast<unsigned char>(payload[index]);
-                std::wcout << std::setw(2) << std::setfill(L'0') << std::hex << static_cast<unsigned int>(byte_value) << L' ';
-                std::wcout << std::dec;
-            } else {
-                std::wcout << L"   ";
-            }
+        cursor = std::fill_n(cursor, 4, L' ');
+        cursor = write_offset(cursor, offset);
+        cursor = std::fill_n(cursor, 2, L' ');
+
+        for (std::size_t column = 0; column < columns; ++column) {
+            const auto& pair = kDumpTables.hex[row[column]];
+            cursor[0] = pair[0];
+            cursor[1] = pair[1];
+            cursor[2] = L' ';
+            cursor += 3;
         }
+        cursor = std::fill_n(cursor, (kDumpRowWidth - columns) * 3, L' ');
 
-        std::wcout << L" |";
-        for (std::size_t column = 0; column < kRowWidth; ++column) {
-            const std::size_t index = offset + column;
-            if (index < size) {
-                const auto byte_value = static_cast<unsigned char>(payload[index]);
-                const bool printable = byte_value >= 32 && byte_value <= 126;
-                std::wcout << (printable ? static_cast<wchar_t>(byte_value) : L'.');
-            } else {
-                std::wcout << L' ';
-            }
+        *cursor++ = L' ';
+        *cursor++ = L'|';
+        for (std::size_t column = 0; column < columns; ++column) {
+            *cursor++ = kDumpTables.text[row[column]];
         }
-        std::wcout << L"|\n";
+        cursor = std::fill_n(cursor, kDumpRowWidth - columns, L' ');
+        *cursor++ = L'|';
+        *cursor++ = L'\n';
     }
 
-    if (size == 0) {
-        std::wcout << L"    <empty>\n";
+    return static_cast<std::size_t>(cursor - out);
+}
+
+void append_hex_dump(std::span<const std::byte> payload, std::wstring& out) {
+    if (payload.empty()) {
+        out.append(L"    <empty>\n");
+        return;
     }
 
-    std::wcout << std::dec << std::setfill(L' ');
+    const std::size_t start = out.size();
+    const std::size_t rows = (payload.size() + kDumpRowWidth - 1) / kDumpRowWidth;
+    out.resize_and_overwrite(start + rows * kDumpMaxRowLength, [payload, start](wchar_t* buffer, std::size_t) {
+        return start + render_hex_dump(payload, buffer + start);
+    });
 }
 
-void write_log(std::wstring_view label, DWORD error_code, std::span<const std::byte> payload, bool include_payload) {
-    const ConsoleColorScope scope {error_code == ERROR_SUCCESS};
+void append_record(std::wstring& out, std::wstring_view label, DWORD error_code, std::span<const std::byte> payload, bool include_payload) {
     const std::wstring message = format_error(error_code);
 
-    std::wcout << L"[" << error_code << L"] " << label;
+    out.push_back(L'[');
+    out.append(std::to_wstring(error_code));
+    out.append(L"] ");
+    out.append(label);
     if (!message.empty()) {
-        std::wcout << L" - " << message;
+        out.append(L" - ");
+        out.append(message);
     }
-    std::wcout << L"\n";
+    out.push_back(L'\n');
 
     if (include_payload) {
-        write_hex_dump(payload);
+        append_hex_dump(payload, out);
     }
 }
 
+// Serialises whole records so concurrent connections do not interleave lines.
+std::mutex& console_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+void write_console(std::wstring_view text, bool success) {
+    const std::lock_guard lock {console_mutex()};
+    const ConsoleColorScope scope {success};
+    std::wcout.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+void write_log(std::wstring_view label, DWORD error_code, std::span<const std::byte> payload, bool include_payload) {
+    // Reused across calls so steady-state logging does not allocate.
+    thread_local std::wstring buffer;
+    buffer.clear();
+    append_record(buffer, label, error_code, payload, include_payload);
+    write_console(buffer, error_code == ERROR_SUCCESS);
+}
+
+std::atomic<AsyncSink*> active_sink {nullptr};
+
 } // namespace
 
+// Bounded multi-producer, single-consumer ring. Each slot carries a sequence
+// number: producers claim a position with a CAS and publish the slot by
+// advancing its sequence, the consumer frees it by advancing it a full lap.
+// Slot buffers keep their capacity, so after warm-up pushes do not allocate.
+class AsyncSink {
+public:
+    AsyncSink(std::size_t capacity, OverflowPolicy policy)
+        : capacity_(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+          mask_(capacity_ - 1),
+          policy_(policy),
+          slots_(std::make_unique<Slot[]>(capacity_)) {
+        for (std::size_t index = 0; index < capacity_; ++index) {
+            slots_[index].sequence.store(index, std::memory_order_relaxed);
+        }
+        consumer_ = std::jthread([this](std::stop_token stop) { run(stop); });
+    }
+
+    AsyncSink(const AsyncSink&) = delete;
+    AsyncSink& operator=(const AsyncSink&) = delete;
+
+    ~AsyncSink() {
+        consumer_.request_stop();
+        consumer_.join();
+    }
+
+    void push(std::wstring_view label, DWORD error_code, std::span<const std::byte> payload, bool include_payload) {
+        std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[position & mask_];
+            const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto lag = static_cast<std::ptrdiff_t>(sequence - position);
+            if (lag == 0) {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    Record& record = slot.record;
+                    record.label.assign(label);
+                    record.error_code = error_code;
+                    record.include_payload = include_payload;
+                    record.payload.assign(payload.begin(), payload.end());
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return;
+                }
+            } else if (lag < 0) {
+                // The consumer is a full ring behind.
+                if (policy_ == OverflowPolicy::drop) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            } else {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void flush() {
+        const std::size_t target = enqueue_position_.load(std::memory_order_acquire);
+        while (written_position_.load(std::memory_order_acquire) < target) {
+            std::this_thread::sleep_for(kIdleWait);
+        }
+    }
+
+private:
+    struct Record {
+        std::wstring label;
+        std::vector<std::byte> payload;
+        DWORD error_code {ERROR_SUCCESS};
+        bool include_payload {false};
+    };
+
+    struct Slot {
+        std::atomic<std::size_t> sequence {0};
+        Record record;
+    };
+
+    static constexpr std::size_t kMaxBatch = 256;
+    static constexpr auto kIdleWait = std::chrono::milliseconds(1);
+
+    void run(std::stop_token stop) {
+        std::wstring batch;
+        while (true) {
+            if (drain(batch) > 0) {
+                continue;
+            }
+            // Producers are gone once stop is requested; one last pass picks up
+            // anything published since the previous drain.
+            if (stop.stop_requested()) {
+                while (drain(batch) > 0) {
+                }
+                return;
+            }
+            std::this_thread::sleep_for(kIdleWait);
+        }
+    }
+
+    // Formats up to kMaxBatch records, switching console colour only where
+    // consecutive records differ, and writes them with as few calls as possible.
+    std::size_t drain(std::wstring& batch) {
+        if (const std::uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed); dropped > 0) {
+            write_console(L"[!] " + std::to_wstring(dropped) + L" log records dropped (queue full)\n", false);
+        }
+
+        std::size_t position = dequeue_position_;
+        std::size_t count = 0;
+        bool batch_success = true;
+        batch.clear();
+
+        while (count < kMaxBatch) {
+            Slot& slot = slots_[position & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                break;
+            }
+
+            const Record& record = slot.record;
+            const bool success = record.error_code == ERROR_SUCCESS;
+            if (!batch.empty() && success != batch_success) {
+                write_console(batch, batch_success);
+                batch.clear();
+            }
+            batch_success = success;
+            append_record(batch, record.label, record.error_code, record.payload, record.include_payload);
+
+            slot.sequence.store(position + capacity_, std::memory_order_release);
+            ++position;
+            ++count;
+        }
+
+        if (!batch.empty()) {
+            write_console(batch, batch_success);
+        }
+        if (count > 0) {
+            std::wcout.flush();
+            dequeue_position_ = position;
+            written_position_.store(position, std::memory_order_release);
+        }
+        return count;
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    const OverflowPolicy policy_;
+    std::unique_ptr<Slot[]> slots_;
+
+    alignas(64) std::atomic<std::size_t> enqueue_position_ {0};
+    alignas(64) std::atomic<std::size_t> written_position_ {0};
+    std::atomic<std::uint64_t> dropped_ {0};
+    std::size_t dequeue_position_ {0};
+
+    std::jthread consumer_;
+};
+
+AsyncScope::AsyncScope(std::size_t capacity, OverflowPolicy policy)
+    : sink_(std::make_unique<AsyncSink>(capacity, policy)) {
+    active_sink.store(sink_.get(), std::memory_order_release);
+}
+
+AsyncScope::~AsyncScope() {
+    active_sink.store(nullptr, std::memory_order_release);
+}
+
+void flush() {
+    if (AsyncSink* sink = active_sink.load(std::memory_order_acquire)) {
+        sink->flush();
+    }
+}
+
 void log_message(std::wstring_view label, DWORD error_code) {
+    if (AsyncSink* sink = active_sink.load(std::memory_order_acquire)) {
+        sink->push(label, error_code, {}, false);
+        return;
+    }
     write_log(label, error_code, {}, false);
 }
 
 void log_message(std::wstring_view label, DWORD error_code, std::span<const std::byte> payload) {
+    if (AsyncSink* sink = active_sink.load(std::memory_order_acquire)) {
+        sink->push(label, error_code, payload, true);
+        return;
+    }
     write_log(label, error_code, payload, true);
 }
 
+void format_hex_dump(std::span<const std::byte> payload, std::wstring& out) {
+    out.clear();
+    append_hex_dump(payload, out);
+}
+
 std::wstring format_error(DWORD error_code) {
     if (error_code == ERROR_SUCCESS) {
         return L"OK";
     }
 
+#if defined(_WIN32)
     LPWSTR buffer = nullptr;
     const DWORD length = ::FormatMessageW(
         FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_IGNORE_INSERTS,
@@ -143,6 +427,13 @@ std::wstring format_error(DWORD error_code) {
     std::wstring message {buffer, buffer + length};
     ::LocalFree(buffer);
     return sanitize_message(message);
+#else
+    const std::string message = std::system_category().message(static_cast<int>(error_code));
+    if (message.empty()) {
+        return L"Unknown error";
+    }
+    return sanitize_message(std::wstring {message.begin(), message.end()});
+#endif
 }
 
 void log_system_error(std::wstring_view label, const std::system_error& error) {
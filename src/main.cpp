@@ -1,28 +1,102 @@
+#include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <limits>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <system_error>
 #include <vector>
 
-#include <windows.h>
-
+#include "pipetool/bench.hpp"
 #include "pipetool/file_sender.hpp"
+#include "pipetool/file_sequence.hpp"
 #include "pipetool/logging.hpp"
-#include "pipetool/pipe_info.hpp"
+#include "pipetool/pingpong.hpp"
+#include "pipetool/pipe_directory.hpp"
+#include "pipetool/pipe_list.hpp"
+#include "pipetool/platform.hpp"
 #include "pipetool/random_sender.hpp"
+#include "pipetool/replay_sender.hpp"
+#include "pipetool/serve.hpp"
+
+#if defined(_WIN32)
+#include "pipetool/pipe_info.hpp"
+#else
+#include <clocale>
+#include <csignal>
+#include <cstdlib>
+#endif
 
 namespace {
 
 constexpr std::size_t kDefaultFuzzSize = 100;
+constexpr std::size_t kDefaultReplySize = 64;
 
 [[nodiscard]] int print_usage() {
-    std::wcerr << L"Usage: pipetool <pipename> <subcommand> [options]\n\n"
+    std::wcerr << L"Usage: pipetool <pipename> <subcommand> [options]\n"
+               << L"       pipetool --list [pattern] [options]\n\n"
                << L"Subcommands:\n"
-               << L"  --stream-file <path>   Stream the entire file into the pipe.\n"
+               << L"  --stream-file <path>   Stream the entire file into the pipe; - reads standard input.\n"
+               << L"                         Several pipes (a pattern, or --to) each get the whole file concurrently.\n"
+               << L"      --chunk-size <bytes>   Bytes per pipe write (default 1048576).\n"
+               << L"      --read-ahead <chunks>  Chunks buffered ahead of the pipe (default 2).\n"
+               << L"      --mmap                 Memory-map the file instead of reading it.\n"
+               << L"      --async <depth>        Keep <depth> writes in flight while draining responses.\n"
+               << L"      --record <file>        Capture every write and read for --replay.\n"
+               << L"      --stripes <n>          Send <n> ranges of the file concurrently over <n> connections.\n"
+               << L"      --to <pipename>        Also send the file to this pipe; repeatable. Names may use * and ?.\n"
+               << L"      --copy                 Copy standard input through buffers instead of using splice/sendfile.\n"
+               << L"      --verify               Check that an echo peer returns exactly what was sent (CRC-32C per 4 KiB block).\n"
+               << L"      --expect <file>        Check the responses against <file> instead of logging them; fails on the first difference.\n"
+               << L"      --mask <offset>:<len>  Skip these bytes of the expected output, e.g. a timestamp; repeatable.\n"
+               << L"  --stream-stdin         Same as --stream-file -, with the same options.\n"
+               << L"  --stream-dir <dir>     Stream every file in <dir>, in name order, over one connection.\n"
+               << L"  --stream-list <file>   Stream the files listed one per line in <file> over one connection.\n"
+               << L"      --chunk-size, --read-ahead and --record as for --stream-file; files are read ahead in the background.\n"
+               << L"      --framing <format>     Send each file whole as one frame: message, u16le, u16be, u32le or u32be.\n"
+               << L"  --bench                Sweep message sizes and report throughput (use a discarding peer).\n"
+               << L"      --min-size <bytes>     Smallest message (default 64).\n"
+               << L"      --max-size <bytes>     Largest message (default 16777216).\n"
+               << L"      --duration <ms>        Time per size step (default 1000).\n"
+               << L"      --bytes <count>        Bytes per size step instead of a duration.\n"
+               << L"      --framing <format>     raw, message, u16le, u16be, u32le or u32be (default raw).\n"
+               << L"      --batch <n>            Coalesce <n> frames into each gathered write (default 1).\n"
+               << L"  --pingpong <bytes>     Time request/reply round trips against an echo peer.\n"
+               << L"      --duration <ms>        Measure for this long (default 5000).\n"
+               << L"      --count <n>            Measure <n> round trips instead of a duration.\n"
+               << L"      --busy-poll            Spin on the pipe instead of blocking reads.\n"
+               << L"      --cpu <index>          Pin the client thread to one processor.\n"
+               << L"      --reply <pipename>     Read replies from a second pipe (e.g. a FIFO pair).\n"
                << L"  --fuzz [bytes]         Send random payloads (default 100 bytes).\n"
-               << L"  --info                 Display security-related pipe metadata.\n";
+               << L"      --connections <n>      Drive <n> client instances concurrently (default 1).\n"
+               << L"      --rate <n>             Payloads per second per connection (default 0, unlimited).\n"
+               << L"      --bytes-per-sec <n>    Also cap each connection's send rate in bytes.\n"
+               << L"      --report-every <ms>    Log latency percentiles at this interval.\n"
+               << L"      --seed <n>             Seed the payload generator to replay a run.\n"
+               << L"      --corpus <dir>         Mutate the inputs in <dir>; inputs that fault the server are saved there.\n"
+               << L"      --record <file>        Capture every payload and read for --replay.\n"
+               << L"      --backoff-initial <ms> First reconnect delay, doubling per attempt (default 10).\n"
+               << L"      --backoff-max <ms>     Longest reconnect delay and connect wait (default 1000).\n"
+               << L"      --reconnect-deadline <ms> Fail a connection that cannot reconnect in time.\n"
+               << L"      --standby <n>          Keep <n> spare connections open per client instance.\n"
+               << L"  --replay <file>        Re-send the payloads of a capture at their recorded pacing.\n"
+               << L"      --flat-out             Send as fast as possible instead.\n"
+               << L"      --expect <file>        Check the responses of a single-connection capture against <file>; waits for the server to close.\n"
+               << L"      --mask <offset>:<len>  As for --stream-file.\n"
+               << L"  --serve [mode]         Serve the pipe as echo (default), sink or reply peer until stopped.\n"
+               << L"      --instances <n>        Pipe instances, or concurrent socket clients (default 4).\n"
+               << L"      --reply-size <bytes>   Size of the fixed reply in reply mode (default 64).\n"
+               << L"      --buffer-size <bytes>  Read size per instance (default 65536).\n"
+               << L"      --idle-timeout <ms>    Disconnect clients that send nothing for this long.\n"
+               << L"  --info [pipename...]   Display security-related metadata of one or more pipes; names may use * and ?.\n"
+               << L"      --jobs <n>             Pipes queried in parallel (default 8).\n"
+               << L"      --sid-cache <file>     Load and save resolved account names here.\n"
+               << L"  --list [pattern]       Print the pipes matching a glob (default *) as a tab-separated table.\n"
+               << L"      --regex                Treat the pattern as a regular expression searched for in each name.\n"
+               << L"      --details              Open every match and add its metadata columns.\n"
+               << L"      --jobs <n>             Pipes queried in parallel with --details (default 8).\n"
+               << L"      --sid-cache <file>     With --details on Windows, load and save resolved account names here.\n";
     return EXIT_FAILURE;
 }
 
@@ -45,10 +119,304 @@ constexpr std::size_t kDefaultFuzzSize = 100;
     }
 }
 
+[[nodiscard]] std::size_t parse_count(const std::wstring& param) {
+    try {
+        std::size_t processed = 0;
+        unsigned long long value = std::stoull(param, &processed, 10);
+        if (processed != param.size()) {
+            throw std::invalid_argument("trailing characters");
+        }
+        if (value > static_cast<unsigned long long>(std::numeric_limits<std::size_t>::max())) {
+            throw std::out_of_range("count overflow");
+        }
+        return static_cast<std::size_t>(value);
+    } catch (const std::exception&) {
+        throw std::invalid_argument("invalid count parameter");
+    }
+}
+
+// Parses a --mask range, <offset>:<length> in bytes, and appends it.
+[[nodiscard]] bool parse_mask(const std::wstring& param, std::vector<pipetool::MaskRange>& masks) {
+    const std::size_t colon = param.find(L':');
+    if (colon == std::wstring::npos) {
+        return false;
+    }
+    masks.push_back({parse_count(param.substr(0, colon)), parse_size(param.substr(colon + 1))});
+    return true;
+}
+
+// Parses the options that may follow --stream-file <path>. Pipes named with
+// --to are appended to `targets`. Returns false on an unrecognised or
+// incomplete option.
+[[nodiscard]] bool parse_stream_options(int argc, wchar_t** argv, int first, pipetool::StreamOptions& options, std::vector<std::wstring>& targets) {
+    for (int index = first; index < argc; ++index) {
+        const std::wstring option = argv[index];
+        if (option == L"--mmap") {
+            options.memory_map = true;
+            continue;
+        }
+        if (option == L"--copy") {
+            options.copy = true;
+            continue;
+        }
+        if (option == L"--verify") {
+            options.verify = true;
+            continue;
+        }
+        if (index + 1 >= argc) {
+            return false;
+        }
+        if (option == L"--chunk-size") {
+            options.chunk_size = parse_size(argv[++index]);
+        } else if (option == L"--read-ahead") {
+            options.read_ahead = parse_count(argv[++index]);
+        } else if (option == L"--async") {
+            options.async_depth = parse_size(argv[++index]);
+        } else if (option == L"--stripes") {
+            options.stripes = parse_size(argv[++index]);
+        } else if (option == L"--to") {
+            targets.push_back(argv[++index]);
+        } else if (option == L"--record") {
+            options.record_path = argv[++index];
+        } else if (option == L"--framing") {
+            if (!pipetool::parse_frame_format(argv[++index], options.framing)) {
+                return false;
+            }
+        } else if (option == L"--expect") {
+            options.expect.path = argv[++index];
+        } else if (option == L"--mask") {
+            if (!parse_mask(argv[++index], options.expect.masks)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return options.expect.masks.empty() || !options.expect.path.empty();
+}
+
+[[nodiscard]] bool parse_bench_options(int argc, wchar_t** argv, int first, pipetool::BenchOptions& options) {
+    for (int index = first; index < argc; ++index) {
+        const std::wstring option = argv[index];
+        if (index + 1 >= argc) {
+            return false;
+        }
+        if (option == L"--min-size") {
+            options.min_size = parse_size(argv[++index]);
+        } else if (option == L"--max-size") {
+            options.max_size = parse_size(argv[++index]);
+        } else if (option == L"--duration") {
+            options.duration = std::chrono::milliseconds {parse_size(argv[++index])};
+        } else if (option == L"--bytes") {
+            options.byte_budget = parse_size(argv[++index]);
+        } else if (option == L"--framing") {
+            if (!pipetool::parse_frame_format(argv[++index], options.framing)) {
+                return false;
+            }
+        } else if (option == L"--batch") {
+            options.batch = parse_size(argv[++index]);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+[[nodiscard]] bool parse_pingpong_options(int argc, wchar_t** argv, int first, pipetool::PingPongOptions& options) {
+    for (int index = first; index < argc; ++index) {
+        const std::wstring option = argv[index];
+        if (option == L"--busy-poll") {
+            options.busy_poll = true;
+            continue;
+        }
+        if (index + 1 >= argc) {
+            return false;
+        }
+        if (option == L"--duration") {
+            options.duration = std::chrono::milliseconds {parse_size(argv[++index])};
+        } else if (option == L"--count") {
+            options.round_trips = parse_size(argv[++index]);
+        } else if (option == L"--cpu") {
+            const std::size_t cpu = parse_count(argv[++index]);
+            if (cpu > std::numeric_limits<unsigned>::max()) {
+                return false;
+            }
+            options.cpu = static_cast<unsigned>(cpu);
+        } else if (option == L"--reply") {
+            options.reply_pipe = argv[++index];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+[[nodiscard]] bool parse_fuzz_options(int argc, wchar_t** argv, int first, pipetool::FuzzOptions& options) {
+    for (int index = first; index < argc; ++index) {
+        const std::wstring option = argv[index];
+        if (index + 1 >= argc) {
+            return false;
+        }
+        if (option == L"--connections") {
+            options.connections = parse_size(argv[++index]);
+        } else if (option == L"--rate") {
+            options.rate = parse_count(argv[++index]);
+        } else if (option == L"--bytes-per-sec") {
+            options.bytes_per_second = parse_count(argv[++index]);
+        } else if (option == L"--report-every") {
+            options.report_interval = std::chrono::milliseconds {parse_size(argv[++index])};
+        } else if (option == L"--seed") {
+            options.seed = parse_count(argv[++index]);
+        } else if (option == L"--corpus") {
+            options.corpus_directory = argv[++index];
+        } else if (option == L"--record") {
+            options.record_path = argv[++index];
+        } else if (option == L"--backoff-initial") {
+            options.reconnect.initial_delay = std::chrono::milliseconds {parse_size(argv[++index])};
+        } else if (option == L"--backoff-max") {
+            options.reconnect.max_delay = std::chrono::milliseconds {parse_size(argv[++index])};
+        } else if (option == L"--reconnect-deadline") {
+            options.reconnect.deadline = std::chrono::milliseconds {parse_size(argv[++index])};
+        } else if (option == L"--standby") {
+            options.reconnect.standby = parse_count(argv[++index]);
+        } else {
+            return false;
+        }
+    }
+    return options.reconnect.initial_delay <= options.reconnect.max_delay;
+}
+
+[[nodiscard]] bool parse_replay_options(int argc, wchar_t** argv, int first, pipetool::ReplayOptions& options) {
+    for (int index = first; index < argc; ++index) {
+        const std::wstring option = argv[index];
+        if (option == L"--flat-out") {
+            options.paced = false;
+            continue;
+        }
+        if (index + 1 >= argc) {
+            return false;
+        }
+        if (option == L"--expect") {
+            options.expect.path = argv[++index];
+        } else if (option == L"--mask") {
+            if (!parse_mask(argv[++index], options.expect.masks)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return options.expect.masks.empty() || !options.expect.path.empty();
+}
+
+// Parses the options that may follow --serve [mode]; the reply is sized here
+// and filled once the options are known.
+[[nodiscard]] bool parse_serve_options(int argc, wchar_t** argv, int first, pipetool::ServeOptions& options, std::size_t& reply_size) {
+    for (int index = first; index < argc; ++index) {
+        const std::wstring option = argv[index];
+        if (index + 1 >= argc) {
+            return false;
+        }
+        if (option == L"--instances") {
+            options.instances = parse_size(argv[++index]);
+        } else if (option == L"--reply-size") {
+            reply_size = parse_size(argv[++index]);
+        } else if (option == L"--buffer-size") {
+            options.buffer_size = parse_size(argv[++index]);
+        } else if (option == L"--idle-timeout") {
+            options.idle_timeout = std::chrono::milliseconds {parse_size(argv[++index])};
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+[[nodiscard]] bool parse_serve_mode(const std::wstring& text, pipetool::ServeMode& mode) {
+    if (text == L"echo") {
+        mode = pipetool::ServeMode::echo;
+    } else if (text == L"sink") {
+        mode = pipetool::ServeMode::sink;
+    } else if (text == L"reply") {
+        mode = pipetool::ServeMode::reply;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Parses what may follow --list: an optional pattern, then options.
+[[nodiscard]] bool parse_list_options(int argc, wchar_t** argv, int first, pipetool::ListOptions& options) {
+    if (first < argc && std::wstring_view {argv[first]}.substr(0, 2) != L"--") {
+        options.pattern = argv[first++];
+    }
+    for (int index = first; index < argc; ++index) {
+        const std::wstring option = argv[index];
+        if (option == L"--regex") {
+            options.regex = true;
+            continue;
+        }
+        if (option == L"--details") {
+            options.details = true;
+            continue;
+        }
+        if (index + 1 >= argc) {
+            return false;
+        }
+        if (option == L"--jobs") {
+            options.jobs = parse_size(argv[++index]);
+        } else if (option == L"--sid-cache") {
+            options.sid_cache = argv[++index];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if defined(_WIN32)
+// Parses what may follow --info: further pipe names or patterns, then options.
+[[nodiscard]] bool parse_info_options(int argc, wchar_t** argv, int first, std::vector<std::wstring>& patterns, pipetool::InfoOptions& options) {
+    for (int index = first; index < argc; ++index) {
+        const std::wstring option = argv[index];
+        if (option.substr(0, 2) != L"--") {
+            patterns.push_back(option);
+            continue;
+        }
+        if (index + 1 >= argc) {
+            return false;
+        }
+        if (option == L"--jobs") {
+            options.jobs = parse_size(argv[++index]);
+        } else if (option == L"--sid-cache") {
+            options.sid_cache = argv[++index];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
 } // namespace
 
 int wmain(int argc, wchar_t** argv) {
     try {
+        // --list takes the pattern where other subcommands take the pipe name,
+        // so it may come first; "pipetool <pattern> --list" works as well.
+        if (argc >= 2 && (std::wstring_view {argv[1]} == L"--list" || (argc >= 3 && std::wstring_view {argv[2]} == L"--list"))) {
+            const bool leading = std::wstring_view {argv[1]} == L"--list";
+            pipetool::ListOptions options;
+            if (!leading) {
+                options.pattern = argv[1];
+            }
+            if (!parse_list_options(argc, argv, leading ? 2 : 3, options)) {
+                std::wcerr << L"Invalid --list option.\n";
+                return print_usage();
+            }
+            return pipetool::show_pipe_list(options);
+        }
+
         if (argc < 3) {
             return print_usage();
         }
@@ -57,37 +425,164 @@ int wmain(int argc, wchar_t** argv) {
         std::wstring subcommand = argv[2];
 
         if (subcommand == L"--stream-file") {
-            if (argc != 4) {
+            if (argc < 4) {
                 std::wcerr << L"--stream-file requires a file path argument.\n";
                 return print_usage();
             }
+            pipetool::StreamOptions options;
+            std::vector<std::wstring> targets {pipe_name};
+            if (!parse_stream_options(argc, argv, 4, options, targets)) {
+                std::wcerr << L"Invalid --stream-file option.\n";
+                return print_usage();
+            }
+            if (options.framing.framing != pipetool::Framing::raw) {
+                std::wcerr << L"--framing applies to --stream-dir and --stream-list.\n";
+                return print_usage();
+            }
             std::filesystem::path file_path {argv[3]};
-            if (!std::filesystem::exists(file_path)) {
+            if (file_path != "-" && !std::filesystem::exists(file_path)) {
                 std::wcerr << L"File not found: " << file_path.wstring() << L"\n";
                 return EXIT_FAILURE;
             }
-            return pipetool::stream_file(pipe_name, file_path);
+            // Logged responses are the output here, so a full queue waits for
+            // the console instead of dropping records; only --fuzz may drop.
+            const pipetool::logging::AsyncScope async_logging {4096, pipetool::logging::OverflowPolicy::block};
+            if (targets.size() > 1 || pipetool::has_wildcards(pipe_name)) {
+                return pipetool::broadcast_file(pipetool::expand_pipe_patterns(targets), file_path, options);
+            }
+            return pipetool::stream_file(pipe_name, file_path, options);
+        }
+
+        if (subcommand == L"--stream-stdin") {
+            pipetool::StreamOptions options;
+            std::vector<std::wstring> targets;
+            if (!parse_stream_options(argc, argv, 3, options, targets) || !targets.empty() || options.framing.framing != pipetool::Framing::raw) {
+                std::wcerr << L"Invalid --stream-stdin option.\n";
+                return print_usage();
+            }
+            const pipetool::logging::AsyncScope async_logging {4096, pipetool::logging::OverflowPolicy::block};
+            return pipetool::stream_file(pipe_name, "-", options);
+        }
+
+        if (subcommand == L"--stream-dir" || subcommand == L"--stream-list") {
+            if (argc < 4) {
+                std::wcerr << subcommand << L" requires a path argument.\n";
+                return print_usage();
+            }
+            pipetool::StreamOptions options;
+            std::vector<std::wstring> targets;
+            if (!parse_stream_options(argc, argv, 4, options, targets) || !targets.empty()) {
+                std::wcerr << L"Invalid " << subcommand << L" option.\n";
+                return print_usage();
+            }
+            const std::filesystem::path source {argv[3]};
+            if (!std::filesystem::exists(source)) {
+                std::wcerr << L"File not found: " << source.wstring() << L"\n";
+                return EXIT_FAILURE;
+            }
+            const auto files = subcommand == L"--stream-dir" ? pipetool::directory_files(source) : pipetool::manifest_files(source);
+            const pipetool::logging::AsyncScope async_logging {4096, pipetool::logging::OverflowPolicy::block};
+            return pipetool::stream_files(pipe_name, files, options);
+        }
+
+        if (subcommand == L"--bench") {
+            pipetool::BenchOptions options;
+            if (!parse_bench_options(argc, argv, 3, options)) {
+                std::wcerr << L"Invalid --bench option.\n";
+                return print_usage();
+            }
+            return pipetool::run_bench(pipe_name, options);
+        }
+
+        if (subcommand == L"--pingpong") {
+            if (argc < 4) {
+                std::wcerr << L"--pingpong requires a message size argument.\n";
+                return print_usage();
+            }
+            pipetool::PingPongOptions options;
+            options.message_size = parse_size(argv[3]);
+            if (!parse_pingpong_options(argc, argv, 4, options)) {
+                std::wcerr << L"Invalid --pingpong option.\n";
+                return print_usage();
+            }
+            return pipetool::run_pingpong(pipe_name, options);
         }
 
         if (subcommand == L"--fuzz") {
-            if (argc > 4) {
-                std::wcerr << L"--fuzz accepts at most one size argument.\n";
+            pipetool::FuzzOptions options;
+            options.max_payload_size = kDefaultFuzzSize;
+            int first_option = 3;
+            if (argc > 3 && std::wstring_view {argv[3]}.substr(0, 2) != L"--") {
+                options.max_payload_size = parse_size(argv[3]);
+                first_option = 4;
+            }
+            if (!parse_fuzz_options(argc, argv, first_option, options)) {
+                std::wcerr << L"Invalid --fuzz option.\n";
+                return print_usage();
+            }
+            const pipetool::logging::AsyncScope async_logging;
+            return pipetool::fuzz_pipe(pipe_name, options);
+        }
+
+        if (subcommand == L"--replay") {
+            if (argc < 4) {
+                std::wcerr << L"--replay requires a capture file argument.\n";
                 return print_usage();
             }
-            std::size_t payload_size = kDefaultFuzzSize;
-            if (argc >= 4) {
-                payload_size = parse_size(argv[3]);
+            pipetool::ReplayOptions options;
+            if (!parse_replay_options(argc, argv, 4, options)) {
+                std::wcerr << L"Invalid --replay option.\n";
+                return print_usage();
             }
-            return pipetool::fuzz_pipe(pipe_name, payload_size);
+            std::filesystem::path capture_path {argv[3]};
+            if (!std::filesystem::exists(capture_path)) {
+                std::wcerr << L"File not found: " << capture_path.wstring() << L"\n";
+                return EXIT_FAILURE;
+            }
+            return pipetool::replay_capture(pipe_name, capture_path, options);
+        }
+
+        if (subcommand == L"--serve") {
+            pipetool::ServeOptions options;
+            int first_option = 3;
+            if (argc > 3 && std::wstring_view {argv[3]}.substr(0, 2) != L"--") {
+                if (!parse_serve_mode(argv[3], options.mode)) {
+                    std::wcerr << L"Unknown --serve mode: " << argv[3] << L"\n";
+                    return print_usage();
+                }
+                first_option = 4;
+            }
+            std::size_t reply_size = kDefaultReplySize;
+            if (!parse_serve_options(argc, argv, first_option, options, reply_size)) {
+                std::wcerr << L"Invalid --serve option.\n";
+                return print_usage();
+            }
+            if (options.mode == pipetool::ServeMode::reply) {
+                options.reply.resize(reply_size);
+                for (std::size_t index = 0; index < reply_size; ++index) {
+                    options.reply[index] = static_cast<std::byte>(index * 131u);
+                }
+            }
+            const pipetool::logging::AsyncScope async_logging {4096, pipetool::logging::OverflowPolicy::block};
+            return pipetool::serve_pipe(pipe_name, options);
         }
 
+#if defined(_WIN32)
         if (subcommand == L"--info") {
-            if (argc != 3) {
-                std::wcerr << L"--info does not accept additional arguments.\n";
+            std::vector<std::wstring> patterns {pipe_name};
+            pipetool::InfoOptions options;
+            if (!parse_info_options(argc, argv, 3, patterns, options)) {
+                std::wcerr << L"Invalid --info option.\n";
                 return print_usage();
             }
-            return pipetool::show_pipe_info(pipe_name);
+            return pipetool::show_pipe_info(patterns, options);
+        }
+#else
+        if (subcommand == L"--info") {
+            std::wcerr << subcommand << L" is only available on Windows.\n";
+            return EXIT_FAILURE;
         }
+#endif
 
         std::wcerr << L"Unknown subcommand: " << subcommand << L"\n";
         return print_usage();
@@ -99,3 +594,26 @@ int wmain(int argc, wchar_t** argv) {
         return EXIT_FAILURE;
     }
 }
+
+#if !defined(_WIN32)
+int main(int argc, char** argv) {
+    std::setlocale(LC_ALL, "");
+    // Writes to a vanished peer should surface as EPIPE, not terminate the process.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::wstring> arguments;
+    arguments.reserve(static_cast<std::size_t>(argc));
+    for (int index = 0; index < argc; ++index) {
+        arguments.push_back(std::filesystem::path {argv[index]}.wstring());
+    }
+
+    std::vector<wchar_t*> wide_argv;
+    wide_argv.reserve(arguments.size() + 1);
+    for (auto& argument : arguments) {
+        wide_argv.push_back(argument.data());
+    }
+    wide_argv.push_back(nullptr);
+
+    return wmain(argc, wide_argv.data());
+}
+#endif
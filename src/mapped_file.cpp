@@ -0,0 +1,201 @@
+#include "pipetool/mapped_file.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include "pipetool/platform.hpp"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pipetool {
+namespace {
+
+[[noreturn]] void throw_last_error(std::string_view context) {
+#if defined(_WIN32)
+    const int error = static_cast<int>(::GetLastError());
+#else
+    const int error = errno;
+#endif
+    throw std::system_error(error, std::system_category(), std::string(context));
+}
+
+#if !defined(_WIN32)
+// Expands a range outward to whole pages, as madvise requires.
+std::pair<std::byte*, std::size_t> page_span(std::span<const std::byte> range) {
+    static const auto page_size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const auto begin = reinterpret_cast<std::uintptr_t>(range.data()) & ~(page_size - 1);
+    const auto end = reinterpret_cast<std::uintptr_t>(range.data() + range.size());
+    return {reinterpret_cast<std::byte*>(begin), static_cast<std::size_t>(end - begin)};
+}
+#endif
+
+} // namespace
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#if defined(_WIN32)
+
+MappedFile MappedFile::open(const std::filesystem::path& path) {
+    HANDLE file = ::CreateFileW(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw_last_error("CreateFileW");
+    }
+
+    LARGE_INTEGER size {};
+    if (!::GetFileSizeEx(file, &size)) {
+        const DWORD error = ::GetLastError();
+        ::CloseHandle(file);
+        throw std::system_error(static_cast<int>(error), std::system_category(), "GetFileSizeEx");
+    }
+    if (static_cast<unsigned long long>(size.QuadPart) > std::numeric_limits<std::size_t>::max()) {
+        ::CloseHandle(file);
+        throw std::runtime_error("File is too large to map");
+    }
+    if (size.QuadPart == 0) {
+        ::CloseHandle(file);
+        return MappedFile {};
+    }
+
+    // The view keeps the section alive, so neither handle is needed afterwards.
+    HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const DWORD mapping_error = ::GetLastError();
+    ::CloseHandle(file);
+    if (mapping == nullptr) {
+        throw std::system_error(static_cast<int>(mapping_error), std::system_category(), "CreateFileMappingW");
+    }
+
+    void* view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    const DWORD view_error = ::GetLastError();
+    ::CloseHandle(mapping);
+    if (view == nullptr) {
+        throw std::system_error(static_cast<int>(view_error), std::system_category(), "MapViewOfFile");
+    }
+
+    return MappedFile {static_cast<std::byte*>(view), static_cast<std::size_t>(size.QuadPart)};
+}
+
+void MappedFile::prefetch(std::span<const std::byte> range) const noexcept {
+    if (range.empty()) {
+        return;
+    }
+    WIN32_MEMORY_RANGE_ENTRY entry {const_cast<std::byte*>(range.data()), range.size()};
+    ::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &entry, 0);
+}
+
+void MappedFile::release(std::span<const std::byte> range) const noexcept {
+    if (range.empty()) {
+        return;
+    }
+    // Unlocking pages that were never locked trims them from the working set.
+    ::VirtualUnlock(const_cast<std::byte*>(range.data()), range.size());
+}
+
+void MappedFile::close() noexcept {
+    if (data_ != nullptr) {
+        ::UnmapViewOfFile(data_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+#else
+
+MappedFile MappedFile::open(const std::filesystem::path& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw_last_error("open");
+    }
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::system_category(), "fstat");
+    }
+    if (!S_ISREG(info.st_mode)) {
+        ::close(fd);
+        throw std::system_error(EINVAL, std::system_category(), "mmap requires a regular file");
+    }
+    if (info.st_size == 0) {
+        ::close(fd);
+        return MappedFile {};
+    }
+
+    const auto size = static_cast<std::size_t>(info.st_size);
+    void* view = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    const int error = errno;
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        throw std::system_error(error, std::system_category(), "mmap");
+    }
+    ::madvise(view, size, MADV_SEQUENTIAL);
+
+    return MappedFile {static_cast<std::byte*>(view), size};
+}
+
+void MappedFile::prefetch(std::span<const std::byte> range) const noexcept {
+    if (range.empty()) {
+        return;
+    }
+    const auto [begin, length] = page_span(range);
+    ::madvise(begin, length, MADV_WILLNEED);
+}
+
+void MappedFile::release(std::span<const std::byte> range) const noexcept {
+    if (range.empty()) {
+        return;
+    }
+    const auto [begin, length] = page_span(range);
+    ::madvise(begin, length, MADV_DONTNEED);
+}
+
+void MappedFile::close() noexcept {
+    if (data_ != nullptr) {
+        ::munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+#endif
+
+std::span<const std::byte> MappedFile::bytes() const noexcept {
+    return {data_, size_};
+}
+
+MappedFile::MappedFile(std::byte* data, std::size_t size) noexcept
+    : data_(data), size_(size) {}
+
+} // namespace pipetool
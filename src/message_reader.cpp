@@ -0,0 +1,108 @@
+#include "pipetool/message_reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace pipetool {
+namespace {
+
+// Size of the first read of each message.
+constexpr std::size_t kInitialRead = 4096;
+// Buffers larger than this are freed instead of pooled.
+constexpr std::size_t kMaxPooledCapacity = 64 * 1024 * 1024;
+constexpr std::size_t kMaxPooledBuffers = 64;
+
+} // namespace
+
+MessageBuffer::MessageBuffer(MessageBuffer&& other) noexcept
+    : storage_(std::move(other.storage_)), capacity_(std::exchange(other.capacity_, 0)), size_(std::exchange(other.size_, 0)) {}
+
+MessageBuffer& MessageBuffer::operator=(MessageBuffer&& other) noexcept {
+    storage_ = std::move(other.storage_);
+    capacity_ = std::exchange(other.capacity_, 0);
+    size_ = std::exchange(other.size_, 0);
+    return *this;
+}
+
+std::span<const std::byte> MessageBuffer::data() const noexcept {
+    return {storage_.get(), size_};
+}
+
+std::size_t MessageBuffer::size() const noexcept {
+    return size_;
+}
+
+std::size_t MessageBuffer::capacity() const noexcept {
+    return capacity_;
+}
+
+std::span<std::byte> MessageBuffer::prepare(std::size_t minimum) {
+    if (capacity_ - size_ < minimum) {
+        const std::size_t capacity = std::max(size_ + minimum, 2 * capacity_);
+        auto storage = std::make_unique_for_overwrite<std::byte[]>(capacity);
+        if (size_ > 0) {
+            std::memcpy(storage.get(), storage_.get(), size_);
+        }
+        storage_ = std::move(storage);
+        capacity_ = capacity;
+    }
+    return {storage_.get() + size_, capacity_ - size_};
+}
+
+void MessageBuffer::commit(std::size_t count) noexcept {
+    size_ += count;
+}
+
+void MessageBuffer::clear() noexcept {
+    size_ = 0;
+}
+
+MessageBuffer BufferPool::acquire() {
+    std::scoped_lock lock(mutex_);
+    if (free_.empty()) {
+        return MessageBuffer {};
+    }
+    MessageBuffer buffer = std::move(free_.back());
+    free_.pop_back();
+    return buffer;
+}
+
+void BufferPool::release(MessageBuffer buffer) {
+    if (buffer.capacity() > kMaxPooledCapacity) {
+        return;
+    }
+    buffer.clear();
+    std::scoped_lock lock(mutex_);
+    if (free_.size() < kMaxPooledBuffers) {
+        free_.push_back(std::move(buffer));
+    }
+}
+
+BufferPool& BufferPool::shared() {
+    static BufferPool pool;
+    return pool;
+}
+
+MessageReader::MessageReader(const PipeClient& pipe, BufferPool& pool)
+    : pipe_(pipe), pool_(pool), buffer_(pool.acquire()) {}
+
+MessageReader::~MessageReader() {
+    pool_.release(std::move(buffer_));
+}
+
+MessageReader::Message MessageReader::next() {
+    buffer_.clear();
+    std::size_t request = kInitialRead;
+    while (true) {
+        // prepare() may hand back more than requested; a warm buffer reads whole messages at once.
+        const auto result = pipe_.read(buffer_.prepare(request));
+        buffer_.commit(result.bytes_transferred);
+        if (result.error != ERROR_MORE_DATA) {
+            return {buffer_.data(), result.error};
+        }
+        request = buffer_.size();
+    }
+}
+
+} // namespace pipetool
@@ -0,0 +1,46 @@
+#include "pipetool/parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pipetool {
+
+void run_parallel(std::size_t count, std::size_t workers, const std::function<void(std::size_t index)>& task) {
+    std::atomic<std::size_t> next {0};
+    std::mutex mutex;
+    std::exception_ptr failure;
+
+    const auto drain = [&] {
+        for (std::size_t index = next.fetch_add(1); index < count; index = next.fetch_add(1)) {
+            try {
+                task(index);
+            } catch (...) {
+                std::scoped_lock lock(mutex);
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+            }
+        }
+    };
+
+    // The calling thread works too, so a single worker spawns nothing.
+    {
+        std::vector<std::jthread> threads;
+        const std::size_t extra = std::min(std::max<std::size_t>(workers, 1), count) - (count > 0 ? 1 : 0);
+        threads.reserve(extra);
+        for (std::size_t thread = 0; thread < extra; ++thread) {
+            threads.emplace_back(drain);
+        }
+        drain();
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+} // namespace pipetool
@@ -0,0 +1,96 @@
+#include "pipetool/payload_generator.hpp"
+
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace pipetool {
+namespace {
+
+constexpr std::uint64_t kIncrement = 0xa0761d6478bd642full;
+constexpr std::uint64_t kMix = 0xe7037ed1a0b428dbull;
+
+struct Product {
+    std::uint64_t low;
+    std::uint64_t high;
+};
+
+Product multiply(std::uint64_t a, std::uint64_t b) noexcept {
+#if defined(_MSC_VER) && defined(_M_X64)
+    Product product;
+    product.low = _umul128(a, b, &product.high);
+    return product;
+#elif defined(__SIZEOF_INT128__)
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return {static_cast<std::uint64_t>(product), static_cast<std::uint64_t>(product >> 64)};
+#else
+    const std::uint64_t a_low = a & 0xFFFFFFFFu;
+    const std::uint64_t a_high = a >> 32;
+    const std::uint64_t b_low = b & 0xFFFFFFFFu;
+    const std::uint64_t b_high = b >> 32;
+    const std::uint64_t low_low = a_low * b_low;
+    const std::uint64_t high_low = a_high * b_low;
+    const std::uint64_t low_high = a_low * b_high;
+    const std::uint64_t cross = (low_low >> 32) + (high_low & 0xFFFFFFFFu) + low_high;
+    return {(cross << 32) | (low_low & 0xFFFFFFFFu), a_high * b_high + (high_low >> 32) + (cross >> 32)};
+#endif
+}
+
+std::uint64_t mix(std::uint64_t counter) noexcept {
+    const Product product = multiply(counter, counter ^ kMix);
+    return product.low ^ product.high;
+}
+
+} // namespace
+
+PayloadGenerator::PayloadGenerator(std::uint64_t seed) noexcept
+    : state_(seed) {}
+
+std::uint64_t PayloadGenerator::next() noexcept {
+    state_ += kIncrement;
+    return mix(state_);
+}
+
+std::size_t PayloadGenerator::uniform(std::size_t low, std::size_t high) noexcept {
+    const std::uint64_t range = static_cast<std::uint64_t>(high - low) + 1;
+    if (range == 0) {
+        return static_cast<std::size_t>(next());
+    }
+    return low + static_cast<std::size_t>(multiply(next(), range).high);
+}
+
+void PayloadGenerator::fill(std::span<std::byte> buffer) noexcept {
+    std::byte* cursor = buffer.data();
+    std::size_t remaining = buffer.size();
+
+    // Four independent counters per iteration keep the multipliers busy.
+    std::uint64_t counter = state_;
+    while (remaining >= 32) {
+        const std::uint64_t words[4] = {
+            mix(counter + kIncrement),
+            mix(counter + 2 * kIncrement),
+            mix(counter + 3 * kIncrement),
+            mix(counter + 4 * kIncrement)};
+        std::memcpy(cursor, words, sizeof(words));
+        counter += 4 * kIncrement;
+        cursor += 32;
+        remaining -= 32;
+    }
+    state_ = counter;
+
+    while (remaining > 0) {
+        const std::uint64_t word = next();
+        const std::size_t count = remaining < sizeof(word) ? remaining : sizeof(word);
+        std::memcpy(cursor, &word, count);
+        cursor += count;
+        remaining -= count;
+    }
+}
+
+std::uint64_t PayloadGenerator::derive_seed(std::uint64_t seed, std::uint64_t stream) noexcept {
+    return mix(seed ^ mix(stream + kIncrement));
+}
+
+} // namespace pipetool
@@ -0,0 +1,206 @@
+#include "pipetool/pingpong.hpp"
+
+#include "pipetool/latency_histogram.hpp"
+#include "pipetool/logging.hpp"
+#include "pipetool/pipe_client.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include "pipetool/platform.hpp"
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace pipetool {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Round trips run before measuring starts, so connection setup and cold
+// caches on either side stay out of the histogram.
+constexpr std::uint64_t kWarmupRoundTrips = 100;
+
+void pin_current_thread(unsigned cpu) {
+#if defined(_WIN32)
+    if (cpu >= sizeof(DWORD_PTR) * 8) {
+        throw std::invalid_argument("processor index out of range");
+    }
+    if (::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR {1} << cpu) == 0) {
+        throw std::system_error(static_cast<int>(::GetLastError()), std::system_category(), "SetThreadAffinityMask");
+    }
+#else
+    if (cpu >= CPU_SETSIZE) {
+        throw std::invalid_argument("processor index out of range");
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (const int error = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set); error != 0) {
+        throw std::system_error(error, std::system_category(), "pthread_setaffinity_np");
+    }
+#endif
+}
+
+// Reads until `expected` bytes have arrived. Returns the read error that cut
+// the reply short, or ERROR_SUCCESS.
+DWORD await_reply(const PipeClient& pipe, std::span<std::byte> buffer, std::size_t expected, bool busy_poll) {
+    std::size_t received = 0;
+    while (received < expected) {
+        if (busy_poll) {
+            const auto peeked = pipe.peek();
+            if (peeked.error != ERROR_SUCCESS) {
+                return peeked.error;
+            }
+            if (peeked.bytes_transferred == 0) {
+                continue;
+            }
+        }
+
+        const auto result = pipe.read(buffer);
+        if (result.error != ERROR_SUCCESS && result.error != ERROR_MORE_DATA) {
+            return result.error;
+        }
+        received += result.bytes_transferred;
+#if defined(_WIN32)
+        // The end of a reply message ends the round trip, whatever its size.
+        if (result.error == ERROR_SUCCESS) {
+            break;
+        }
+#endif
+    }
+    return ERROR_SUCCESS;
+}
+
+#if defined(_WIN32)
+// A message-mode server reads a whole request before echoing it, so each
+// message is written in one piece.
+constexpr std::size_t kWriteSlice = SIZE_MAX;
+#else
+// A byte-stream echo peer answers while the request is still arriving. A
+// request larger than the socket buffers, written whole before reading,
+// would leave both sides blocked, so it goes out in slices with the reply
+// read as far as it has come between them.
+constexpr std::size_t kWriteSlice = 64 * 1024;
+#endif
+
+// Sends one request and waits for the whole reply.
+DWORD exchange(const PipeClient& pipe, const PipeClient& replies, std::span<const std::byte> message, std::span<std::byte> buffer, bool busy_poll) {
+    std::size_t received = 0;
+    for (auto rest = message; !rest.empty();) {
+        const auto slice = rest.first(std::min(rest.size(), kWriteSlice));
+        pipe.write(slice);
+        rest = rest.subspan(slice.size());
+        while (!rest.empty() && received < message.size()) {
+            const auto peeked = replies.peek();
+            if (peeked.error != ERROR_SUCCESS) {
+                return peeked.error;
+            }
+            if (peeked.bytes_transferred == 0) {
+                break;
+            }
+            const auto result = replies.read(buffer.first(std::min<std::size_t>(buffer.size(), peeked.bytes_transferred)));
+            if (result.error != ERROR_SUCCESS && result.error != ERROR_MORE_DATA) {
+                return result.error;
+            }
+            received += result.bytes_transferred;
+        }
+    }
+    return received < message.size() ? await_reply(replies, buffer, message.size() - received, busy_poll) : ERROR_SUCCESS;
+}
+
+std::wstring describe_run(std::uint64_t round_trips, Clock::duration elapsed) {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+
+    std::wostringstream label;
+    label.setf(std::ios::fixed);
+    label.precision(1);
+    label << L"Round trips: " << round_trips << L" in " << seconds * 1000.0 << L" ms";
+    if (seconds > 0.0) {
+        label << L" (" << static_cast<double>(round_trips) / seconds << L"/s)";
+    }
+    return label.str();
+}
+
+} // namespace
+
+int run_pingpong(const std::wstring& pipe_name, const PingPongOptions& options) {
+    if (options.message_size == 0) {
+        std::wcerr << L"Message size must be greater than zero.\n";
+        return EXIT_FAILURE;
+    }
+
+    try {
+        if (options.cpu) {
+            pin_current_thread(*options.cpu);
+        }
+
+        std::optional<PipeClient> reply_pipe;
+        if (!options.reply_pipe.empty()) {
+            reply_pipe.emplace(PipeClient::connect(options.reply_pipe, GENERIC_READ, 0, FILE_ATTRIBUTE_NORMAL));
+        }
+        const DWORD access = reply_pipe ? GENERIC_WRITE : GENERIC_WRITE | GENERIC_READ;
+        const PipeClient pipe = PipeClient::connect(pipe_name, access, 0, FILE_ATTRIBUTE_NORMAL);
+        const PipeClient& replies = reply_pipe ? *reply_pipe : pipe;
+
+        std::vector<std::byte> message(options.message_size);
+        for (std::size_t index = 0; index < message.size(); ++index) {
+            message[index] = static_cast<std::byte>(index * 131u);
+        }
+        std::vector<std::byte> reply(std::max<std::size_t>(options.message_size, 4096));
+        auto histogram = std::make_unique<LatencyHistogram>();
+
+        logging::log_message(L"Ping-pong started", ERROR_SUCCESS);
+
+        std::uint64_t completed = 0;
+        Clock::time_point started;
+        Clock::time_point deadline;
+        for (std::uint64_t round_trip = 0;; ++round_trip) {
+            if (round_trip == kWarmupRoundTrips) {
+                started = Clock::now();
+                deadline = started + options.duration;
+            }
+
+            const auto sent = Clock::now();
+            if (const DWORD error = exchange(pipe, replies, message, reply, options.busy_poll); error != ERROR_SUCCESS) {
+                logging::log_message(L"Pipe read error", error);
+                return EXIT_FAILURE;
+            }
+            const auto received = Clock::now();
+
+            if (round_trip < kWarmupRoundTrips) {
+                continue;
+            }
+            histogram->record(received - sent);
+            ++completed;
+
+            if (options.round_trips != 0 ? completed >= options.round_trips : received >= deadline) {
+                break;
+            }
+        }
+
+        std::wcout << describe_run(completed, Clock::now() - started) << L"\n"
+                   << L"Latency: " << describe_percentiles(*histogram) << L"\n";
+        return EXIT_SUCCESS;
+    } catch (const std::system_error& ex) {
+        logging::log_system_error(L"Ping-pong failed", ex);
+        return EXIT_FAILURE;
+    } catch (const std::exception& ex) {
+        std::cerr << "Ping-pong failed: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
+
+} // namespace pipetool
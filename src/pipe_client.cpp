@@ -1,10 +1,12 @@
 #include "pipetool/pipe_client.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <vector>
 
 #include <windows.h>
 
@@ -32,6 +34,10 @@ std::wstring normalize_pipe_name(const std::wstring& pipe_name) {
 
 } // namespace
 
+std::wstring qualify_pipe_name(const std::wstring& pipe_name) {
+    return normalize_pipe_name(pipe_name);
+}
+
 PipeClient::PipeClient(PipeClient&& other) noexcept {
     *this = std::move(other);
 }
@@ -50,10 +56,13 @@ PipeClient::~PipeClient() {
     close();
 }
 
-PipeClient PipeClient::connect(const std::wstring& pipe_name, DWORD desired_access, DWORD share_mode, DWORD flags_and_attributes) {
+PipeClient PipeClient::connect(const std::wstring& pipe_name, DWORD desired_access, DWORD share_mode, DWORD flags_and_attributes,
+    std::chrono::milliseconds timeout) {
     const std::wstring qualified = normalize_pipe_name(pipe_name);
 
-    if (!::WaitNamedPipeW(qualified.c_str(), 5000)) {
+    // A zero timeout would mean NMPWAIT_USE_DEFAULT_WAIT, the server's default.
+    const auto wait = std::clamp<std::chrono::milliseconds::rep>(timeout.count(), 1, NMPWAIT_WAIT_FOREVER - 1);
+    if (!::WaitNamedPipeW(qualified.c_str(), static_cast<DWORD>(wait))) {
         throw_last_error("WaitNamedPipeW");
     }
 
@@ -85,13 +94,14 @@ std::wstring PipeClient::qualified_name() const {
     return full_name_;
 }
 
-void PipeClient::write(std::span<const std::byte> buffer) const {
+std::size_t PipeClient::write(std::span<const std::byte> buffer) const {
     if (!is_valid()) {
         throw std::runtime_error("Pipe handle is not valid");
     }
 
     const std::byte* data = buffer.data();
     std::size_t remaining = buffer.size();
+    std::size_t calls = 0;
 
     while (remaining > 0) {
         const DWORD chunk = remaining > static_cast<std::size_t>(std::numeric_limits<DWORD>::max())
@@ -99,6 +109,7 @@ void PipeClient::write(std::span<const std::byte> buffer) const {
             : static_cast<DWORD>(remaining);
 
         DWORD written = 0;
+        ++calls;
         if (!::WriteFile(handle_, reinterpret_cast<LPCVOID>(data), chunk, &written, nullptr)) {
                throw_last_error("WriteFile");
         }
@@ -110,6 +121,18 @@ void PipeClient::write(std::span<const std::byte> buffer) const {
         data += written;
         remaining -= written;
     }
+    return calls;
+}
+
+// WriteFileGather only works on unbuffered files, so pipes get the buffers
+// coalesced into one staging copy and a single WriteFile.
+std::size_t PipeClient::write_gathered(std::span<const std::span<const std::byte>> buffers) const {
+    thread_local std::vector<std::byte> staging;
+    staging.clear();
+    for (const auto& buffer : buffers) {
+        staging.insert(staging.end(), buffer.begin(), buffer.end());
+    }
+    return write(staging);
 }
 
 PipeClient::ReadResult PipeClient::read(std::span<std::byte> buffer) const {
@@ -130,6 +153,25 @@ PipeClient::ReadResult PipeClient::read(std::span<std::byte> buffer) const {
     return {read, ERROR_SUCCESS};
 }
 
+PipeClient::ReadResult PipeClient::peek() const {
+    if (!is_valid()) {
+        throw std::runtime_error("Pipe handle is not valid");
+    }
+
+    DWORD available = 0;
+    if (!::PeekNamedPipe(handle_, nullptr, 0, nullptr, &available, nullptr)) {
+        return {0, ::GetLastError()};
+    }
+    return {available, ERROR_SUCCESS};
+}
+
+DWORD PipeClient::flush() const noexcept {
+    if (!::FlushFileBuffers(handle_)) {
+        return ::GetLastError();
+    }
+    return ERROR_SUCCESS;
+}
+
 PipeClient::PipeClient(HANDLE handle, std::wstring full_name) noexcept
     : handle_(handle), full_name_(std::move(full_name)) {}
 
@@ -0,0 +1,334 @@
+#include "pipetool/pipe_client.hpp"
+
+#include "pipetool/pipe_directory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <climits>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace pipetool {
+namespace {
+
+constexpr auto kConnectRetryInterval = std::chrono::milliseconds(10);
+
+std::filesystem::path normalize_pipe_name(const std::wstring& pipe_name) {
+    std::filesystem::path path {pipe_name};
+    if (path.has_parent_path()) {
+        return path;
+    }
+    return pipe_directory() / path;
+}
+
+[[noreturn]] void throw_error(int error, std::string_view context) {
+    throw std::system_error(error, std::system_category(), std::string(context));
+}
+
+bool is_transient(int error) {
+    return error == ENOENT || error == ECONNREFUSED || error == EAGAIN || error == ENXIO;
+}
+
+int connect_socket(const std::string& path) {
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+int open_fifo(const std::string& path, bool for_write) {
+    // O_NONBLOCK makes a writer fail with ENXIO instead of hanging when no
+    // reader is attached yet, which lets the caller retry until the deadline.
+    const int fd = ::open(path.c_str(), (for_write ? O_WRONLY : O_RDONLY) | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    const int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) != 0) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+std::wstring qualify_pipe_name(const std::wstring& pipe_name) {
+    return normalize_pipe_name(pipe_name).wstring();
+}
+
+PipeClient::PipeClient(PipeClient&& other) noexcept {
+    *this = std::move(other);
+}
+
+PipeClient& PipeClient::operator=(PipeClient&& other) noexcept {
+    if (this != &other) {
+        close();
+        handle_ = other.handle_;
+        full_name_ = std::move(other.full_name_);
+        is_socket_ = other.is_socket_;
+        readable_ = other.readable_;
+        other.handle_ = INVALID_HANDLE_VALUE;
+    }
+    return *this;
+}
+
+PipeClient::~PipeClient() {
+    close();
+}
+
+// The timeout plays the part of WaitNamedPipeW's: transient failures are
+// retried until it expires.
+PipeClient PipeClient::connect(const std::wstring& pipe_name, DWORD desired_access, DWORD /*share_mode*/, DWORD /*flags_and_attributes*/,
+    std::chrono::milliseconds timeout) {
+    const std::filesystem::path qualified = normalize_pipe_name(pipe_name);
+    const std::string native = qualified.string();
+    const bool wants_write = (desired_access & GENERIC_WRITE) != 0;
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true) {
+        struct stat info {};
+        const char* context = "stat";
+        if (::stat(native.c_str(), &info) == 0) {
+            if (S_ISSOCK(info.st_mode)) {
+                context = "connect";
+                const int fd = connect_socket(native);
+                if (fd >= 0) {
+                    PipeClient client {fd, qualified.wstring()};
+                    client.is_socket_ = true;
+                    client.readable_ = true;
+                    return client;
+                }
+            } else if (S_ISFIFO(info.st_mode)) {
+                context = "open";
+                const int fd = open_fifo(native, wants_write);
+                if (fd >= 0) {
+                    PipeClient client {fd, qualified.wstring()};
+                    client.readable_ = !wants_write;
+                    return client;
+                }
+            } else {
+                throw_error(ENOTSOCK, "stat");
+            }
+        }
+
+        const int error = errno;
+        if (!is_transient(error) || std::chrono::steady_clock::now() >= deadline) {
+            throw_error(error, context);
+        }
+        std::this_thread::sleep_for(kConnectRetryInterval);
+    }
+}
+
+bool PipeClient::is_valid() const noexcept {
+    return handle_ != INVALID_HANDLE_VALUE;
+}
+
+HANDLE PipeClient::native_handle() const noexcept {
+    return handle_;
+}
+
+std::wstring PipeClient::qualified_name() const {
+    return full_name_;
+}
+
+std::size_t PipeClient::write(std::span<const std::byte> buffer) const {
+    if (!is_valid()) {
+        throw std::runtime_error("Pipe handle is not valid");
+    }
+
+    const std::byte* data = buffer.data();
+    std::size_t remaining = buffer.size();
+    std::size_t calls = 0;
+
+    while (remaining > 0) {
+        // MSG_NOSIGNAL turns a vanished peer into EPIPE rather than SIGPIPE.
+        ++calls;
+        const ssize_t written = is_socket_
+            ? ::send(handle_, data, remaining, MSG_NOSIGNAL)
+            : ::write(handle_, data, remaining);
+        if (written < 0) {
+            const int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+            throw_error(error, is_socket_ ? "send" : "write");
+        }
+
+        if (written == 0) {
+            throw std::runtime_error("write wrote zero bytes");
+        }
+
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+    return calls;
+}
+
+std::size_t PipeClient::write_gathered(std::span<const std::span<const std::byte>> buffers) const {
+    if (!is_valid()) {
+        throw std::runtime_error("Pipe handle is not valid");
+    }
+
+    std::array<iovec, IOV_MAX> vectors {};
+    std::size_t next = 0;
+    // Bytes of buffers[next] already written by an earlier partial write.
+    std::size_t consumed = 0;
+    std::size_t calls = 0;
+
+    while (true) {
+        while (next < buffers.size() && consumed == buffers[next].size()) {
+            ++next;
+            consumed = 0;
+        }
+        if (next == buffers.size()) {
+            return calls;
+        }
+
+        std::size_t count = 0;
+        for (std::size_t index = next; index < buffers.size() && count < vectors.size(); ++index) {
+            const std::size_t skip = index == next ? consumed : 0;
+            if (buffers[index].size() > skip) {
+                vectors[count++] = {const_cast<std::byte*>(buffers[index].data()) + skip, buffers[index].size() - skip};
+            }
+        }
+
+        ++calls;
+        msghdr message {};
+        message.msg_iov = vectors.data();
+        message.msg_iovlen = count;
+        const ssize_t written = is_socket_
+            ? ::sendmsg(handle_, &message, MSG_NOSIGNAL)
+            : ::writev(handle_, vectors.data(), static_cast<int>(count));
+        if (written < 0) {
+            const int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+            throw_error(error, is_socket_ ? "sendmsg" : "writev");
+        }
+        if (written == 0) {
+            throw std::runtime_error("write wrote zero bytes");
+        }
+
+        for (auto left = static_cast<std::size_t>(written); left > 0;) {
+            const std::size_t step = std::min(left, buffers[next].size() - consumed);
+            consumed += step;
+            left -= step;
+            if (consumed == buffers[next].size()) {
+                ++next;
+                consumed = 0;
+            }
+        }
+    }
+}
+
+PipeClient::ReadResult PipeClient::read(std::span<std::byte> buffer) const {
+    if (!is_valid()) {
+        throw std::runtime_error("Pipe handle is not valid");
+    }
+
+    // The write end of a FIFO has no response channel; report it as drained.
+    if (buffer.empty() || !readable_) {
+        return {0, ERROR_SUCCESS};
+    }
+
+    const std::size_t request = std::min<std::size_t>(buffer.size(), std::numeric_limits<DWORD>::max());
+    while (true) {
+        const ssize_t read = ::read(handle_, buffer.data(), request);
+        if (read < 0) {
+            const int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+            return {0, static_cast<DWORD>(error)};
+        }
+        // End of stream is how a POSIX peer signals what Windows reports as a broken pipe.
+        if (read == 0) {
+            return {0, ERROR_BROKEN_PIPE};
+        }
+        return {static_cast<DWORD>(read), ERROR_SUCCESS};
+    }
+}
+
+PipeClient::ReadResult PipeClient::peek() const {
+    if (!is_valid()) {
+        throw std::runtime_error("Pipe handle is not valid");
+    }
+    if (!readable_) {
+        return {0, ERROR_SUCCESS};
+    }
+
+    pollfd descriptor {handle_, POLLIN, 0};
+    int ready = 0;
+    do {
+        ready = ::poll(&descriptor, 1, 0);
+    } while (ready < 0 && errno == EINTR);
+    if (ready < 0) {
+        return {0, static_cast<DWORD>(errno)};
+    }
+    if (ready == 0) {
+        return {0, ERROR_SUCCESS};
+    }
+
+    int available = 0;
+    if (::ioctl(handle_, FIONREAD, &available) != 0) {
+        return {0, static_cast<DWORD>(errno)};
+    }
+    // Readable with nothing queued means the peer has closed its end.
+    if (available == 0) {
+        return {0, ERROR_BROKEN_PIPE};
+    }
+    return {static_cast<DWORD>(available), ERROR_SUCCESS};
+}
+
+DWORD PipeClient::flush() const noexcept {
+    // Sockets and FIFOs have no client-side write cache; data is already queued to the peer.
+    return ERROR_SUCCESS;
+}
+
+PipeClient::PipeClient(HANDLE handle, std::wstring full_name) noexcept
+    : handle_(handle), full_name_(std::move(full_name)) {}
+
+void PipeClient::close() noexcept {
+    if (handle_ != INVALID_HANDLE_VALUE) {
+        ::close(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+    }
+}
+
+} // namespace pipetool
@@ -0,0 +1,117 @@
+#include "pipetool/pipe_directory.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cwctype>
+#include <iterator>
+#include <optional>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace pipetool {
+namespace {
+
+wchar_t fold(wchar_t character) {
+#if defined(_WIN32)
+    return static_cast<wchar_t>(std::towupper(static_cast<std::wint_t>(character)));
+#else
+    return character;
+#endif
+}
+
+} // namespace
+
+std::filesystem::path pipe_directory() {
+#if defined(_WIN32)
+    return L"\\\\.\\pipe\\";
+#else
+    const char* directory = std::getenv("PIPETOOL_PIPE_DIR");
+    return (directory != nullptr && *directory != '\0') ? directory : "/tmp";
+#endif
+}
+
+std::vector<std::wstring> list_pipes() {
+    std::vector<std::wstring> names;
+#if defined(_WIN32)
+    WIN32_FIND_DATAW data {};
+    const HANDLE find = ::FindFirstFileW(L"\\\\.\\pipe\\*", &data);
+    if (find == INVALID_HANDLE_VALUE) {
+        const DWORD error = ::GetLastError();
+        if (error == ERROR_FILE_NOT_FOUND) {
+            return names;
+        }
+        throw std::system_error(static_cast<int>(error), std::system_category(), "FindFirstFileW");
+    }
+    do {
+        names.emplace_back(data.cFileName);
+    } while (::FindNextFileW(find, &data));
+    ::FindClose(find);
+#else
+    std::error_code error;
+    for (std::filesystem::directory_iterator entries(pipe_directory(), error), end; !error && entries != end; entries.increment(error)) {
+        std::error_code status_error;
+        const auto status = entries->status(status_error);
+        if (!status_error && (std::filesystem::is_socket(status) || std::filesystem::is_fifo(status))) {
+            names.push_back(entries->path().filename().wstring());
+        }
+    }
+    if (error) {
+        throw std::system_error(error, "directory_iterator");
+    }
+#endif
+    return names;
+}
+
+bool has_wildcards(std::wstring_view pattern) {
+    return pattern.find_first_of(L"*?") != std::wstring_view::npos;
+}
+
+bool glob_match(std::wstring_view pattern, std::wstring_view name) {
+    // Backtracks only to the most recent `*`, which keeps matching linear
+    // in practice and never exponential.
+    std::size_t p = 0;
+    std::size_t n = 0;
+    std::optional<std::size_t> star;
+    std::size_t star_name = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && pattern[p] == L'*') {
+            star = p++;
+            star_name = n;
+        } else if (p < pattern.size() && (pattern[p] == L'?' || fold(pattern[p]) == fold(name[n]))) {
+            ++p;
+            ++n;
+        } else if (star) {
+            p = *star + 1;
+            n = ++star_name;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == L'*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+std::vector<std::wstring> expand_pipe_patterns(const std::vector<std::wstring>& patterns) {
+    std::optional<std::vector<std::wstring>> existing;
+    std::vector<std::wstring> names;
+    for (const std::wstring& pattern : patterns) {
+        if (!has_wildcards(pattern)) {
+            names.push_back(pattern);
+            continue;
+        }
+        if (!existing) {
+            existing = list_pipes();
+            std::sort(existing->begin(), existing->end());
+        }
+        std::copy_if(existing->begin(), existing->end(), std::back_inserter(names),
+            [&pattern](const std::wstring& name) { return glob_match(pattern, name); });
+    }
+    return names;
+}
+
+} // namespace pipetool
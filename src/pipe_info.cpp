@@ -1,17 +1,24 @@
 #include "pipetool/pipe_info.hpp"
 
 #include "pipetool/logging.hpp"
+#include "pipetool/parallel.hpp"
 #include "pipetool/pipe_client.hpp"
+#include "pipetool/pipe_directory.hpp"
+#include "pipetool/sid_cache.hpp"
 
 #include <aclapi.h>
 #include <sddl.h>
 
+#include <atomic>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <system_error>
+#include <vector>
 
 #include <windows.h>
 
@@ -55,11 +62,7 @@ std::wstring sid_to_string(PSID sid) {
     return L"<unavailable>";
 }
 
-std::wstring lookup_account(PSID sid) {
-    if (!sid || !::IsValidSid(sid)) {
-        return L"<invalid sid>";
-    }
-
+std::optional<std::wstring> lookup_account_uncached(PSID sid) {
     wchar_t name[256] = {0};
     wchar_t domain[256] = {0};
     DWORD name_size = static_cast<DWORD>(std::size(name));
@@ -76,7 +79,15 @@ std::wstring lookup_account(PSID sid) {
         return account;
     }
 
-    return L"<unresolved>";
+    return std::nullopt;
+}
+
+std::wstring lookup_account(PSID sid) {
+    if (!sid || !::IsValidSid(sid)) {
+        return L"<invalid sid>";
+    }
+    const auto account = SidNameCache::shared().resolve(sid_to_string(sid), [sid] { return lookup_account_uncached(sid); });
+    return account.value_or(L"<unresolved>");
 }
 
 std::wstring ace_type_to_string(const ACE_HEADER* header) {
@@ -131,28 +142,25 @@ std::wstring access_mask_to_string(DWORD mask) {
     return result;
 }
 
-void print_acl(PACL acl) {
+void collect_acl(PACL acl, PipeInfo& info) {
     if (!acl) {
-        std::wcout << L"DACL: <none>\n";
+        info.dacl_note = L"<none>";
         return;
     }
 
-    ACL_SIZE_INFORMATION info {};
-    if (!::GetAclInformation(acl, &info, sizeof(info), AclSizeInformation)) {
-        std::wcout << L"DACL: <unavailable>\n";
+    ACL_SIZE_INFORMATION size_info {};
+    if (!::GetAclInformation(acl, &size_info, sizeof(size_info), AclSizeInformation)) {
+        info.dacl_note = L"<unavailable>";
         return;
     }
 
-    std::wcout << L"DACL entries: " << info.AceCount << L"\n";
-
-    for (DWORD index = 0; index < info.AceCount; ++index) {
+    for (DWORD index = 0; index < size_info.AceCount; ++index) {
         void* ace_ptr = nullptr;
         if (!::GetAce(acl, index, &ace_ptr)) {
             continue;
         }
 
         auto* header = static_cast<ACE_HEADER*>(ace_ptr);
-        std::wstring type = ace_type_to_string(header);
         DWORD mask = 0;
         PSID sid = nullptr;
 
@@ -166,95 +174,172 @@ void print_acl(PACL acl) {
             sid = reinterpret_cast<PSID>(&ace->SidStart);
         }
 
-        std::wcout << L"  [" << index << L"] " << type << L" " << lookup_account(sid) << L" (" << sid_to_string(sid)
-                   << L") rights=" << access_mask_to_string(mask) << L"\n";
+        info.dacl.push_back({ace_type_to_string(header), lookup_account(sid), sid_to_string(sid), access_mask_to_string(mask)});
     }
 }
 
+// Prints each pipe's block as soon as it and every block before it are done,
+// so output keeps the order given while slow pipes are still being queried.
+class OrderedOutput {
+public:
+    explicit OrderedOutput(std::size_t count)
+        : blocks_(count) {}
+
+    void complete(std::size_t index, std::wstring block) {
+        std::scoped_lock lock(mutex_);
+        blocks_[index] = std::move(block);
+        while (next_ < blocks_.size() && blocks_[next_]) {
+            std::wcout << *blocks_[next_] << std::flush;
+            blocks_[next_].reset();
+            ++next_;
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::optional<std::wstring>> blocks_;
+    std::size_t next_ {0};
+};
+
 } // namespace
 
-int show_pipe_info(const std::wstring& pipe_name) {
-    try {
-        PipeClient pipe = PipeClient::connect(pipe_name, GENERIC_READ | GENERIC_WRITE | READ_CONTROL, FILE_SHARE_READ | FILE_SHARE_WRITE, FILE_ATTRIBUTE_NORMAL);
-
-        DWORD flags = 0;
-        DWORD out_buffer_size = 0;
-        DWORD in_buffer_size = 0;
-        DWORD max_instances = 0;
-        if (!::GetNamedPipeInfo(pipe.native_handle(), &flags, &out_buffer_size, &in_buffer_size, &max_instances)) {
-            logging::log_message(L"GetNamedPipeInfo", ::GetLastError());
-        }
+PipeInfo query_pipe_info(const std::wstring& pipe_name) {
+    PipeClient pipe = PipeClient::connect(pipe_name, GENERIC_READ | GENERIC_WRITE | READ_CONTROL, FILE_SHARE_READ | FILE_SHARE_WRITE, FILE_ATTRIBUTE_NORMAL);
 
-        DWORD state = 0;
-        DWORD cur_instances = 0;
-        DWORD max_collection = 0;
-        DWORD collection_timeout = 0;
-        wchar_t server_user[256] = {0};
-
-        if (!::GetNamedPipeHandleStateW(
-                pipe.native_handle(),
-                &state,
-                &cur_instances,
-                &max_collection,
-                &collection_timeout,
-                server_user,
-                static_cast<DWORD>(std::size(server_user)))) {
-            const DWORD state_error = ::GetLastError();
-            if (state_error == ERROR_INVALID_PARAMETER) {
-                logging::log_message(L"GetNamedPipeHandleState (server impersonation unavailable)", state_error);
-                if (!::GetNamedPipeHandleStateW(
-                        pipe.native_handle(),
-                        &state,
-                        &cur_instances,
-                        &max_collection,
-                        &collection_timeout,
-                        nullptr,
-                        0)) {
-                    logging::log_message(L"GetNamedPipeHandleState", ::GetLastError());
-                }
-            } else {
-                logging::log_message(L"GetNamedPipeHandleState", state_error);
-            }
-        }
+    PipeInfo info;
+    info.name = pipe.qualified_name();
 
-        std::wcout << L"Pipe name: " << pipe.qualified_name() << L"\n";
-        std::wcout << L"Type: " << describe_pipe_type(flags) << L"\n";
-        std::wcout << L"Read mode: " << describe_read_mode(state) << L"\n";
-        std::wcout << L"Wait mode: " << describe_wait_mode(state) << L"\n";
-        std::wcout << L"Current instances: " << cur_instances << L"\n";
-        std::wcout << L"Max instances: " << max_instances << L"\n";
-        std::wcout << L"Inbound quota (bytes): " << in_buffer_size << L"\n";
-        std::wcout << L"Outbound quota (bytes): " << out_buffer_size << L"\n";
-        std::wcout << L"Collect data timeout (ms): " << collection_timeout << L"\n";
-        if (server_user[0] != L'\0') {
-            std::wcout << L"Server user: " << server_user << L"\n";
-        }
+    DWORD flags = 0;
+    if (!::GetNamedPipeInfo(pipe.native_handle(), &flags, &info.outbound_quota, &info.inbound_quota, &info.max_instances)) {
+        logging::log_message(L"GetNamedPipeInfo", ::GetLastError());
+    }
+
+    DWORD state = 0;
+    DWORD max_collection = 0;
+    wchar_t server_user[256] = {0};
 
-        PSID owner_sid = nullptr;
-        PACL dacl = nullptr;
-        PSECURITY_DESCRIPTOR security_descriptor = nullptr;
-        DWORD security_status = ::GetSecurityInfo(
+    if (!::GetNamedPipeHandleStateW(
             pipe.native_handle(),
-            SE_KERNEL_OBJECT,
-            OWNER_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION,
-            &owner_sid,
-            nullptr,
-            &dacl,
-            nullptr,
-            &security_descriptor);
-
-        if (security_status == ERROR_SUCCESS) {
-            std::wcout << L"Owner: " << lookup_account(owner_sid) << L" (" << sid_to_string(owner_sid) << L")\n";
-            print_acl(dacl);
+            &state,
+            &info.current_instances,
+            &max_collection,
+            &info.collect_timeout,
+            server_user,
+            static_cast<DWORD>(std::size(server_user)))) {
+        const DWORD state_error = ::GetLastError();
+        if (state_error == ERROR_INVALID_PARAMETER) {
+            logging::log_message(L"GetNamedPipeHandleState (server impersonation unavailable)", state_error);
+            if (!::GetNamedPipeHandleStateW(
+                    pipe.native_handle(),
+                    &state,
+                    &info.current_instances,
+                    &max_collection,
+                    &info.collect_timeout,
+                    nullptr,
+                    0)) {
+                logging::log_message(L"GetNamedPipeHandleState", ::GetLastError());
+            }
         } else {
-            logging::log_message(L"GetSecurityInfo", security_status);
+            logging::log_message(L"GetNamedPipeHandleState", state_error);
         }
+    }
+
+    info.type = describe_pipe_type(flags);
+    info.read_mode = describe_read_mode(state);
+    info.wait_mode = describe_wait_mode(state);
+    info.server_user = server_user;
+
+    PSID owner_sid = nullptr;
+    PACL dacl = nullptr;
+    PSECURITY_DESCRIPTOR security_descriptor = nullptr;
+    DWORD security_status = ::GetSecurityInfo(
+        pipe.native_handle(),
+        SE_KERNEL_OBJECT,
+        OWNER_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION,
+        &owner_sid,
+        nullptr,
+        &dacl,
+        nullptr,
+        &security_descriptor);
+
+    if (security_status == ERROR_SUCCESS) {
+        info.owner = lookup_account(owner_sid);
+        info.owner_sid = sid_to_string(owner_sid);
+        collect_acl(dacl, info);
+    } else {
+        logging::log_message(L"GetSecurityInfo", security_status);
+    }
+
+    if (security_descriptor) {
+        ::LocalFree(security_descriptor);
+    }
+
+    return info;
+}
+
+void print_pipe_info(const PipeInfo& info, std::wostream& out) {
+    out << L"Pipe name: " << info.name << L"\n";
+    out << L"Type: " << info.type << L"\n";
+    out << L"Read mode: " << info.read_mode << L"\n";
+    out << L"Wait mode: " << info.wait_mode << L"\n";
+    out << L"Current instances: " << info.current_instances << L"\n";
+    out << L"Max instances: " << info.max_instances << L"\n";
+    out << L"Inbound quota (bytes): " << info.inbound_quota << L"\n";
+    out << L"Outbound quota (bytes): " << info.outbound_quota << L"\n";
+    out << L"Collect data timeout (ms): " << info.collect_timeout << L"\n";
+    if (!info.server_user.empty()) {
+        out << L"Server user: " << info.server_user << L"\n";
+    }
 
-        if (security_descriptor) {
-            ::LocalFree(security_descriptor);
+    if (info.owner.empty()) {
+        return;
+    }
+    out << L"Owner: " << info.owner << L" (" << info.owner_sid << L")\n";
+    if (!info.dacl_note.empty()) {
+        out << L"DACL: " << info.dacl_note << L"\n";
+        return;
+    }
+    out << L"DACL entries: " << info.dacl.size() << L"\n";
+    for (std::size_t index = 0; index < info.dacl.size(); ++index) {
+        const AceInfo& ace = info.dacl[index];
+        out << L"  [" << index << L"] " << ace.type << L" " << ace.account << L" (" << ace.sid << L") rights=" << ace.rights << L"\n";
+    }
+}
+
+int show_pipe_info(const std::vector<std::wstring>& patterns, const InfoOptions& options) {
+    try {
+        SidNameCache& cache = SidNameCache::shared();
+        if (!options.sid_cache.empty() && !cache.load(options.sid_cache)) {
+            logging::log_message(L"SID cache not found, starting empty", ERROR_SUCCESS);
         }
 
-        return EXIT_SUCCESS;
+        const std::vector<std::wstring> names = expand_pipe_patterns(patterns);
+        if (names.empty()) {
+            std::wcerr << L"No pipes match.\n";
+            return EXIT_FAILURE;
+        }
+
+        OrderedOutput output {names.size()};
+        std::atomic<bool> failed {false};
+        run_parallel(names.size(), options.jobs, [&](std::size_t index) {
+            std::wostringstream block;
+            if (index > 0) {
+                block << L"\n";
+            }
+            try {
+                print_pipe_info(query_pipe_info(names[index]), block);
+            } catch (const std::system_error& ex) {
+                failed = true;
+                logging::log_system_error(L"Pipe info failed for " + names[index], ex);
+                block << L"Pipe name: " << names[index] << L"\n" << L"Error: unavailable\n";
+            }
+            output.complete(index, block.str());
+        });
+
+        if (!options.sid_cache.empty()) {
+            cache.save(options.sid_cache);
+        }
+        return failed ? EXIT_FAILURE : EXIT_SUCCESS;
     } catch (const std::system_error& ex) {
         logging::log_system_error(L"Pipe info failed", ex);
         return EXIT_FAILURE;
@@ -0,0 +1,198 @@
+#include "pipetool/pipe_list.hpp"
+
+#include "pipetool/logging.hpp"
+#include "pipetool/parallel.hpp"
+#include "pipetool/pipe_client.hpp"
+#include "pipetool/pipe_directory.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "pipetool/platform.hpp"
+
+#if defined(_WIN32)
+#include "pipetool/pipe_info.hpp"
+#include "pipetool/sid_cache.hpp"
+#else
+#include <pwd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pipetool {
+namespace {
+
+using Row = std::vector<std::wstring>;
+
+// Keeps every field on one line and in one column.
+std::wstring table_field(std::wstring value) {
+    std::replace_if(value.begin(), value.end(), [](wchar_t character) {
+        return character == L'\t' || character == L'\r' || character == L'\n';
+    }, L' ');
+    return value.empty() ? L"-" : value;
+}
+
+void print_row(const Row& row) {
+    std::wstring line;
+    for (const std::wstring& field : row) {
+        if (!line.empty()) {
+            line += L'\t';
+        }
+        line += table_field(field);
+    }
+    line += L'\n';
+    std::wcout << line;
+}
+
+std::wstring describe_error(const std::system_error& error) {
+    return logging::format_error(static_cast<DWORD>(error.code().value()));
+}
+
+#if defined(_WIN32)
+
+Row detail_header() {
+    return {L"name", L"type", L"read_mode", L"instances", L"max_instances", L"inbound_quota", L"outbound_quota", L"owner", L"owner_sid", L"dacl_entries", L"status"};
+}
+
+Row query_details(const std::wstring& name) {
+    try {
+        const PipeInfo info = query_pipe_info(name);
+        return {name, info.type, info.read_mode, std::to_wstring(info.current_instances), std::to_wstring(info.max_instances),
+            std::to_wstring(info.inbound_quota), std::to_wstring(info.outbound_quota), info.owner, info.owner_sid,
+            info.dacl_note.empty() ? std::to_wstring(info.dacl.size()) : info.dacl_note, L"OK"};
+    } catch (const std::system_error& ex) {
+        Row row(detail_header().size());
+        row.front() = name;
+        row.back() = describe_error(ex);
+        return row;
+    }
+}
+
+#else
+
+Row detail_header() {
+    return {L"name", L"kind", L"mode", L"owner", L"status"};
+}
+
+std::wstring owner_name(uid_t uid) {
+    passwd entry {};
+    passwd* result = nullptr;
+    char buffer[1024];
+    if (::getpwuid_r(uid, &entry, buffer, sizeof(buffer), &result) == 0 && result != nullptr) {
+        return std::filesystem::path {entry.pw_name}.wstring();
+    }
+    return std::to_wstring(uid);
+}
+
+// Sockets are probed with a single connect attempt, which tells a live server
+// from a stale socket file. FIFOs are not: opening one and closing it again
+// would end the stream for its reader.
+Row query_details(const std::wstring& name) {
+    const std::string path = std::filesystem::path {qualify_pipe_name(name)}.string();
+    struct stat info {};
+    if (::stat(path.c_str(), &info) != 0) {
+        Row row(detail_header().size());
+        row.front() = name;
+        row.back() = logging::format_error(static_cast<DWORD>(errno));
+        return row;
+    }
+
+    char mode[8];
+    std::snprintf(mode, sizeof(mode), "%04o", static_cast<unsigned int>(info.st_mode & 07777));
+    Row row {name, S_ISSOCK(info.st_mode) ? L"socket" : L"fifo", std::filesystem::path {mode}.wstring(), owner_name(info.st_uid), L""};
+
+    if (S_ISSOCK(info.st_mode)) {
+        try {
+            PipeClient::connect(name, GENERIC_READ | GENERIC_WRITE, 0, FILE_ATTRIBUTE_NORMAL, std::chrono::milliseconds {0});
+            row.back() = L"OK";
+        } catch (const std::system_error& ex) {
+            row.back() = describe_error(ex);
+        }
+    }
+    return row;
+}
+
+#endif
+
+} // namespace
+
+PipeNameFilter::PipeNameFilter(std::wstring pattern, bool regex)
+    : is_regex_(regex) {
+    if (!regex) {
+        glob_ = std::move(pattern);
+        return;
+    }
+    auto flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+#if defined(_WIN32)
+    flags |= std::regex_constants::icase;
+#endif
+    regex_ = std::wregex(pattern, flags);
+}
+
+bool PipeNameFilter::matches(std::wstring_view name) const {
+    if (!is_regex_) {
+        return glob_match(glob_, name);
+    }
+    return std::regex_search(name.begin(), name.end(), regex_);
+}
+
+int show_pipe_list(const ListOptions& options) {
+    try {
+        const PipeNameFilter filter {options.pattern, options.regex};
+
+        std::vector<std::wstring> names = list_pipes();
+        std::erase_if(names, [&filter](const std::wstring& name) { return !filter.matches(name); });
+        std::sort(names.begin(), names.end());
+
+        if (!options.details) {
+            std::wstring table = L"name\n";
+            for (const std::wstring& name : names) {
+                table += table_field(name);
+                table += L'\n';
+            }
+            std::wcout << table << std::flush;
+            return EXIT_SUCCESS;
+        }
+
+#if defined(_WIN32)
+        SidNameCache& cache = SidNameCache::shared();
+        if (!options.sid_cache.empty() && !cache.load(options.sid_cache)) {
+            logging::log_message(L"SID cache not found, starting empty", ERROR_SUCCESS);
+        }
+#endif
+
+        std::vector<Row> rows(names.size());
+        run_parallel(names.size(), options.jobs, [&](std::size_t index) {
+            rows[index] = query_details(names[index]);
+        });
+
+#if defined(_WIN32)
+        if (!options.sid_cache.empty()) {
+            cache.save(options.sid_cache);
+        }
+#endif
+
+        print_row(detail_header());
+        for (const Row& row : rows) {
+            print_row(row);
+        }
+        std::wcout << std::flush;
+        return EXIT_SUCCESS;
+    } catch (const std::system_error& ex) {
+        logging::log_system_error(L"Pipe listing failed", ex);
+        return EXIT_FAILURE;
+    } catch (const std::exception& ex) {
+        std::cerr << "Pipe listing failed: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
+
+} // namespace pipetool
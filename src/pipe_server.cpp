@@ -0,0 +1,286 @@
+#include "pipetool/pipe_server.hpp"
+
+#include "pipetool/message_reader.hpp"
+#include "pipetool/pipe_client.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <windows.h>
+
+namespace pipetool {
+namespace {
+
+[[noreturn]] void throw_error(DWORD error, const char* context) {
+    throw std::system_error(static_cast<int>(error), std::system_category(), context);
+}
+
+constexpr std::size_t kInitialRead = 4096;
+
+} // namespace
+
+struct PipeServer::Impl {
+    enum class State {
+        connecting,
+        reading,
+        writing,
+    };
+
+    // OVERLAPPED must stay the first member so a completion can be mapped back
+    // to its instance. Each instance has at most one operation outstanding.
+    struct Instance {
+        OVERLAPPED overlapped {};
+        HANDLE handle {INVALID_HANDLE_VALUE};
+        State state {State::connecting};
+        bool pending {false};
+        bool cancelling {false};
+        std::chrono::steady_clock::time_point last_active;
+        // The request being reassembled, which echo mode also writes back.
+        MessageBuffer message;
+        std::size_t read_request {kInitialRead};
+    };
+
+    ServeOptions options;
+    HANDLE port {nullptr};
+    std::vector<Instance> instances;
+    std::vector<InstanceStats> stats;
+
+    Impl() = default;
+    Impl(const Impl&) = delete;
+    Impl& operator=(const Impl&) = delete;
+
+    // Also runs when the constructor fails part way, with some instances
+    // already connecting.
+    ~Impl() {
+        // Outstanding operations reference the instances; they must finish first.
+        for (Instance& instance : instances) {
+            if (instance.pending) {
+                ::CancelIoEx(instance.handle, nullptr);
+            }
+        }
+        while (std::any_of(instances.begin(), instances.end(), [](const Instance& instance) { return instance.pending; })) {
+            std::array<OVERLAPPED_ENTRY, 16> entries {};
+            ULONG count = 0;
+            if (!::GetQueuedCompletionStatusEx(port, entries.data(), static_cast<ULONG>(entries.size()), &count, INFINITE, FALSE)) {
+                break;
+            }
+            for (ULONG index = 0; index < count; ++index) {
+                reinterpret_cast<Instance*>(entries[index].lpOverlapped)->pending = false;
+            }
+        }
+
+        for (Instance& instance : instances) {
+            if (instance.handle != INVALID_HANDLE_VALUE) {
+                ::CloseHandle(instance.handle);
+            }
+            BufferPool::shared().release(std::move(instance.message));
+        }
+        if (port != nullptr) {
+            ::CloseHandle(port);
+        }
+    }
+
+    std::size_t index_of(const Instance& instance) const {
+        return static_cast<std::size_t>(&instance - instances.data());
+    }
+
+    void start_connect(Instance& instance) {
+        instance.overlapped = {};
+        instance.state = State::connecting;
+        instance.cancelling = false;
+        instance.message.clear();
+        instance.read_request = kInitialRead;
+        if (::ConnectNamedPipe(instance.handle, &instance.overlapped)) {
+            instance.pending = true;
+            return;
+        }
+        const DWORD error = ::GetLastError();
+        if (error == ERROR_IO_PENDING) {
+            instance.pending = true;
+        } else if (error == ERROR_PIPE_CONNECTED) {
+            // The client beat us to it and no completion will be queued.
+            if (!::PostQueuedCompletionStatus(port, 0, 0, &instance.overlapped)) {
+                throw_error(::GetLastError(), "PostQueuedCompletionStatus");
+            }
+            instance.pending = true;
+        } else {
+            throw_error(error, "ConnectNamedPipe");
+        }
+    }
+
+    void restart(Instance& instance) {
+        ::DisconnectNamedPipe(instance.handle);
+        start_connect(instance);
+    }
+
+    // With a completion port attached, every outcome other than an immediate
+    // failure is reported through the port.
+    bool start_read(Instance& instance) {
+        instance.overlapped = {};
+        instance.state = State::reading;
+        const std::span<std::byte> space = instance.message.prepare(instance.read_request);
+        const DWORD request = static_cast<DWORD>(std::min<std::size_t>(space.size(), std::numeric_limits<DWORD>::max()));
+        if (!::ReadFile(instance.handle, space.data(), request, nullptr, &instance.overlapped)) {
+            const DWORD error = ::GetLastError();
+            if (error != ERROR_IO_PENDING && error != ERROR_MORE_DATA) {
+                return false;
+            }
+        }
+        instance.pending = true;
+        return true;
+    }
+
+    bool start_write(Instance& instance, std::span<const std::byte> data) {
+        instance.overlapped = {};
+        instance.state = State::writing;
+        if (!::WriteFile(instance.handle, data.data(), static_cast<DWORD>(data.size()), nullptr, &instance.overlapped)) {
+            if (::GetLastError() != ERROR_IO_PENDING) {
+                return false;
+            }
+        }
+        instance.pending = true;
+        return true;
+    }
+
+    // Returns false once the client has gone.
+    bool complete(Instance& instance, DWORD bytes, DWORD error) {
+        InstanceStats& counters = stats[index_of(instance)];
+        switch (instance.state) {
+        case State::connecting:
+            if (error != ERROR_SUCCESS && error != ERROR_PIPE_CONNECTED) {
+                return false;
+            }
+            ++counters.connections;
+            instance.last_active = std::chrono::steady_clock::now();
+            return start_read(instance);
+
+        case State::reading:
+            if (error != ERROR_SUCCESS && error != ERROR_MORE_DATA) {
+                return false;
+            }
+            instance.message.commit(bytes);
+            instance.last_active = std::chrono::steady_clock::now();
+            if (error == ERROR_MORE_DATA) {
+                instance.read_request = instance.message.size();
+                return start_read(instance);
+            }
+            ++counters.messages;
+            counters.bytes_received += instance.message.size();
+            if (options.mode == ServeMode::echo) {
+                return start_write(instance, instance.message.data());
+            }
+            if (options.mode == ServeMode::reply) {
+                return start_write(instance, options.reply);
+            }
+            instance.message.clear();
+            instance.read_request = kInitialRead;
+            return start_read(instance);
+
+        case State::writing:
+            if (error != ERROR_SUCCESS) {
+                return false;
+            }
+            counters.bytes_sent += bytes;
+            instance.message.clear();
+            instance.read_request = kInitialRead;
+            return start_read(instance);
+        }
+        return false;
+    }
+
+    // Cancelling the pending read completes it with ERROR_OPERATION_ABORTED,
+    // which disconnects the client.
+    void disconnect_idle() {
+        const auto now = std::chrono::steady_clock::now();
+        for (Instance& instance : instances) {
+            if (instance.state == State::reading && instance.pending && !instance.cancelling
+                && now - instance.last_active >= options.idle_timeout) {
+                instance.cancelling = ::CancelIoEx(instance.handle, &instance.overlapped) != FALSE;
+            }
+        }
+    }
+};
+
+PipeServer::PipeServer(const std::wstring& pipe_name, const ServeOptions& options)
+    : impl_(std::make_unique<Impl>()) {
+    if (options.instances == 0 || options.buffer_size == 0) {
+        throw std::invalid_argument("instance count and buffer size must be greater than zero");
+    }
+    if (options.instances >= PIPE_UNLIMITED_INSTANCES) {
+        throw std::invalid_argument("too many pipe instances");
+    }
+
+    Impl& impl = *impl_;
+    impl.options = options;
+    impl.instances.resize(options.instances);
+    impl.stats.resize(options.instances);
+
+    impl.port = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    if (impl.port == nullptr) {
+        throw_error(::GetLastError(), "CreateIoCompletionPort");
+    }
+
+    const std::wstring qualified = qualify_pipe_name(pipe_name);
+    const DWORD buffer_size = static_cast<DWORD>(std::min<std::size_t>(options.buffer_size, std::numeric_limits<DWORD>::max()));
+    for (std::size_t index = 0; index < impl.instances.size(); ++index) {
+        Impl::Instance& instance = impl.instances[index];
+        instance.message = BufferPool::shared().acquire();
+
+        // The first instance claims the name, so a second server fails instead of sharing it.
+        const DWORD open_mode = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (index == 0 ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0);
+        instance.handle = ::CreateNamedPipeW(qualified.c_str(), open_mode,
+            PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+            static_cast<DWORD>(options.instances), buffer_size, buffer_size, 0, nullptr);
+        if (instance.handle == INVALID_HANDLE_VALUE) {
+            throw_error(::GetLastError(), "CreateNamedPipeW");
+        }
+        if (::CreateIoCompletionPort(instance.handle, impl.port, 0, 0) == nullptr) {
+            throw_error(::GetLastError(), "CreateIoCompletionPort");
+        }
+        impl.start_connect(instance);
+    }
+}
+
+PipeServer::~PipeServer() = default;
+
+void PipeServer::run_for(std::chrono::milliseconds timeout) {
+    Impl& impl = *impl_;
+    std::array<OVERLAPPED_ENTRY, 64> entries {};
+    ULONG count = 0;
+    const DWORD wait = static_cast<DWORD>(std::clamp<std::chrono::milliseconds::rep>(timeout.count(), 0, INFINITE - 1));
+    if (!::GetQueuedCompletionStatusEx(impl.port, entries.data(), static_cast<ULONG>(entries.size()), &count, wait, FALSE)) {
+        const DWORD error = ::GetLastError();
+        if (error != WAIT_TIMEOUT) {
+            throw_error(error, "GetQueuedCompletionStatusEx");
+        }
+        count = 0;
+    }
+
+    for (ULONG index = 0; index < count; ++index) {
+        auto& instance = *reinterpret_cast<Impl::Instance*>(entries[index].lpOverlapped);
+        instance.pending = false;
+        DWORD bytes = 0;
+        DWORD error = ERROR_SUCCESS;
+        if (!::GetOverlappedResult(instance.handle, &instance.overlapped, &bytes, FALSE)) {
+            error = ::GetLastError();
+        }
+        if (!impl.complete(instance, bytes, error)) {
+            impl.restart(instance);
+        }
+    }
+    if (impl.options.idle_timeout.count() > 0) {
+        impl.disconnect_idle();
+    }
+}
+
+const std::vector<InstanceStats>& PipeServer::stats() const noexcept {
+    return impl_->stats;
+}
+
+} // namespace pipetool
@@ -0,0 +1,297 @@
+#include "pipetool/pipe_server.hpp"
+
+#include "pipetool/pipe_client.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace pipetool {
+namespace {
+
+[[noreturn]] void throw_error(int error, const char* context) {
+    throw std::system_error(error, std::system_category(), context);
+}
+
+// epoll data for the listening socket; instances use their index.
+constexpr std::uint64_t kListener = std::numeric_limits<std::uint64_t>::max();
+// Reads per readiness event, so one busy client cannot starve the rest.
+// Level-triggered epoll reports the client again if more is queued.
+constexpr int kReadsPerEvent = 16;
+
+} // namespace
+
+struct PipeServer::Impl {
+    struct Instance {
+        int fd {-1};
+        // Bytes still to be written back to the client, from `sent` onward.
+        std::vector<std::byte> pending;
+        std::size_t sent {0};
+        std::uint32_t registered_events {0};
+        std::chrono::steady_clock::time_point last_active;
+    };
+
+    std::filesystem::path path;
+    ServeOptions options;
+    int listen_fd {-1};
+    int epoll_fd {-1};
+    bool accepting {true};
+    std::vector<Instance> instances;
+    std::vector<InstanceStats> stats;
+    std::vector<std::byte> read_buffer;
+
+    Impl() = default;
+    Impl(const Impl&) = delete;
+    Impl& operator=(const Impl&) = delete;
+
+    // Also runs when the constructor fails part way. A listening fd means the
+    // socket file was bound by us, so it is removed with it.
+    ~Impl() {
+        for (Instance& instance : instances) {
+            if (instance.fd >= 0) {
+                ::close(instance.fd);
+            }
+        }
+        if (epoll_fd >= 0) {
+            ::close(epoll_fd);
+        }
+        if (listen_fd >= 0) {
+            ::close(listen_fd);
+            ::unlink(path.c_str());
+        }
+    }
+
+    void control(int operation, int fd, std::uint32_t events, std::uint64_t data) {
+        epoll_event event {};
+        event.events = events;
+        event.data.u64 = data;
+        if (::epoll_ctl(epoll_fd, operation, fd, &event) != 0) {
+            throw_error(errno, "epoll_ctl");
+        }
+    }
+
+    // A client with unsent output is not read from, so a slow reader pushes
+    // back on its own writer rather than growing `pending` without bound.
+    void update(std::size_t index) {
+        Instance& instance = instances[index];
+        const std::uint32_t events = instance.sent < instance.pending.size() ? EPOLLOUT : EPOLLIN;
+        if (events != instance.registered_events) {
+            control(EPOLL_CTL_MOD, instance.fd, events, index);
+            instance.registered_events = events;
+        }
+    }
+
+    // Stops accepting while every instance is busy; further clients wait in
+    // the listen backlog, as they would for a free pipe instance on Windows.
+    void update_listener() {
+        const bool has_free = std::any_of(instances.begin(), instances.end(), [](const Instance& instance) { return instance.fd < 0; });
+        if (has_free != accepting) {
+            control(EPOLL_CTL_MOD, listen_fd, has_free ? static_cast<std::uint32_t>(EPOLLIN) : 0u, kListener);
+            accepting = has_free;
+        }
+    }
+
+    void accept_clients() {
+        for (Instance& instance : instances) {
+            if (instance.fd >= 0) {
+                continue;
+            }
+            const int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED) {
+                    break;
+                }
+                throw_error(errno, "accept4");
+            }
+            const auto index = static_cast<std::size_t>(&instance - instances.data());
+            instance.fd = fd;
+            instance.registered_events = EPOLLIN;
+            instance.last_active = std::chrono::steady_clock::now();
+            control(EPOLL_CTL_ADD, fd, EPOLLIN, index);
+            ++stats[index].connections;
+        }
+        update_listener();
+    }
+
+    void disconnect(std::size_t index) {
+        Instance& instance = instances[index];
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, instance.fd, nullptr);
+        ::close(instance.fd);
+        instance.fd = -1;
+        instance.pending.clear();
+        instance.sent = 0;
+        update_listener();
+    }
+
+    // Returns false once the client has gone.
+    bool flush_pending(std::size_t index) {
+        Instance& instance = instances[index];
+        while (instance.sent < instance.pending.size()) {
+            const ssize_t written = ::send(instance.fd, instance.pending.data() + instance.sent, instance.pending.size() - instance.sent, MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return true;
+                }
+                return false;
+            }
+            instance.sent += static_cast<std::size_t>(written);
+            stats[index].bytes_sent += static_cast<std::uint64_t>(written);
+            // Reads pause while output is pending, so a client draining it
+            // is active even though it sends nothing.
+            instance.last_active = std::chrono::steady_clock::now();
+        }
+        instance.pending.clear();
+        instance.sent = 0;
+        return true;
+    }
+
+    // Returns false once the client has gone.
+    bool read_client(std::size_t index) {
+        Instance& instance = instances[index];
+        for (int reads = 0; reads < kReadsPerEvent && instance.sent == instance.pending.size(); ++reads) {
+            const ssize_t read = ::read(instance.fd, read_buffer.data(), read_buffer.size());
+            if (read < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            if (read == 0) {
+                return false;
+            }
+            instance.last_active = std::chrono::steady_clock::now();
+            ++stats[index].messages;
+            stats[index].bytes_received += static_cast<std::uint64_t>(read);
+            if (options.mode == ServeMode::sink) {
+                continue;
+            }
+            if (options.mode == ServeMode::echo) {
+                instance.pending.assign(read_buffer.begin(), read_buffer.begin() + read);
+            } else {
+                instance.pending = options.reply;
+            }
+            if (!flush_pending(index)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void service(std::size_t index, std::uint32_t events) {
+        const bool alive = (events & EPOLLOUT) != 0 ? flush_pending(index) && read_client(index) : read_client(index);
+        if (!alive) {
+            disconnect(index);
+            return;
+        }
+        update(index);
+    }
+
+    void disconnect_idle() {
+        const auto now = std::chrono::steady_clock::now();
+        for (std::size_t index = 0; index < instances.size(); ++index) {
+            if (instances[index].fd >= 0 && now - instances[index].last_active >= options.idle_timeout) {
+                disconnect(index);
+            }
+        }
+    }
+};
+
+PipeServer::PipeServer(const std::wstring& pipe_name, const ServeOptions& options)
+    : impl_(std::make_unique<Impl>()) {
+    if (options.instances == 0 || options.buffer_size == 0) {
+        throw std::invalid_argument("instance count and buffer size must be greater than zero");
+    }
+
+    Impl& impl = *impl_;
+    impl.path = qualify_pipe_name(pipe_name);
+    impl.options = options;
+    impl.instances.resize(options.instances);
+    impl.stats.resize(options.instances);
+    impl.read_buffer.resize(options.buffer_size);
+
+    const std::string native = impl.path.string();
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (native.size() >= sizeof(address.sun_path)) {
+        throw_error(ENAMETOOLONG, "bind");
+    }
+    std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+
+    // A socket left behind by an earlier server is replaced; anything else is not ours to remove.
+    struct stat info {};
+    if (::lstat(native.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            throw_error(EEXIST, "bind");
+        }
+        ::unlink(native.c_str());
+    }
+
+    impl.listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (impl.listen_fd < 0) {
+        throw_error(errno, "socket");
+    }
+    if (::bind(impl.listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        const int error = errno;
+        ::close(impl.listen_fd);
+        impl.listen_fd = -1;
+        throw_error(error, "bind");
+    }
+    if (::listen(impl.listen_fd, SOMAXCONN) != 0) {
+        throw_error(errno, "listen");
+    }
+
+    impl.epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (impl.epoll_fd < 0) {
+        throw_error(errno, "epoll_create1");
+    }
+    impl.control(EPOLL_CTL_ADD, impl.listen_fd, EPOLLIN, kListener);
+}
+
+PipeServer::~PipeServer() = default;
+
+void PipeServer::run_for(std::chrono::milliseconds timeout) {
+    Impl& impl = *impl_;
+    std::array<epoll_event, 64> events {};
+    const int count = ::epoll_wait(impl.epoll_fd, events.data(), static_cast<int>(events.size()),
+        static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(timeout.count(), 0, std::numeric_limits<int>::max())));
+    if (count < 0) {
+        if (errno == EINTR) {
+            return;
+        }
+        throw_error(errno, "epoll_wait");
+    }
+
+    for (int index = 0; index < count; ++index) {
+        if (events[index].data.u64 == kListener) {
+            impl.accept_clients();
+        } else {
+            impl.service(static_cast<std::size_t>(events[index].data.u64), events[index].events);
+        }
+    }
+    if (impl.options.idle_timeout.count() > 0) {
+        impl.disconnect_idle();
+    }
+}
+
+const std::vector<InstanceStats>& PipeServer::stats() const noexcept {
+    return impl_->stats;
+}
+
+} // namespace pipetool
@@ -1,163 +1,568 @@
 #include "pipetool/random_sender.hpp"
 
+#include "pipetool/async_pipe.hpp"
+#include "pipetool/capture.hpp"
+#include "pipetool/connection_manager.hpp"
+#include "pipetool/corpus.hpp"
+#include "pipetool/latency_histogram.hpp"
 #include "pipetool/logging.hpp"
+#include "pipetool/payload_generator.hpp"
 #include "pipetool/pipe_client.hpp"
+#include "pipetool/stop_request.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <chrono>
-#include <conio.h>
+#include <deque>
+#include <iomanip>
 #include <iostream>
-#include <random>
+#include <memory>
+#include <optional>
+#include <sstream>
 #include <span>
 #include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <string_view>
 #include <system_error>
 #include <thread>
 #include <vector>
 
-#include <windows.h>
+#include "pipetool/platform.hpp"
+
+#if defined(_WIN32)
+#include <timeapi.h>
+#endif
 
 namespace pipetool {
 namespace {
 
-void log_error(const std::wstring& label, DWORD error) {
-    logging::log_message(label, error);
+struct ConnectionStats {
+    std::atomic<std::uint64_t> payloads {0};
+    std::atomic<std::uint64_t> bytes_sent {0};
+    std::atomic<std::uint64_t> responses {0};
+    std::atomic<std::uint64_t> bytes_received {0};
+    std::atomic<std::uint64_t> errors {0};
+    std::atomic<std::uint64_t> reconnects {0};
+    std::atomic<std::uint64_t> reconnect_ns {0};
+    std::atomic<std::uint64_t> saved {0};
+    // Round trips measured from each payload's scheduled send time.
+    LatencyHistogram latency;
+    std::atomic<bool> failed {false};
+};
+
+// Open-loop send schedule. Each payload is due one spacing after the previous
+// one was due, whether or not it went out on time, so a server that stalls the
+// sender is charged for the whole stall rather than hiding it.
+struct SendSchedule {
+    std::chrono::duration<double> per_message {0.0};
+    std::chrono::duration<double> per_byte {0.0};
+
+    bool paced() const {
+        return per_message.count() > 0.0 || per_byte.count() > 0.0;
+    }
+
+    std::chrono::steady_clock::duration spacing(std::size_t bytes) const {
+        const std::chrono::duration<double> gap = std::max(per_message, per_byte * static_cast<double>(bytes));
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(gap);
+    }
+};
+
+struct Worker {
+    const std::wstring& pipe_name;
+    // Upper bound on an input; with a corpus, also the largest seed.
+    std::size_t max_payload_size;
+    std::size_t index;
+    std::uint64_t seed;
+    SendSchedule schedule;
+    const ReconnectPolicy& reconnect;
+    // Appended to log labels so concurrent connections can be told apart.
+    std::wstring tag;
+    ConnectionStats& stats;
+    Corpus* corpus;
+    CaptureWriter* capture;
+};
+
+#if defined(_WIN32)
+// Waits on the completion port and sleeps are only as fine as the system
+// timer, 15.6 ms by default, which would make paced sends bunch up.
+class TimerResolutionScope {
+public:
+    TimerResolutionScope() {
+        ::timeBeginPeriod(1);
+    }
+    TimerResolutionScope(const TimerResolutionScope&) = delete;
+    TimerResolutionScope& operator=(const TimerResolutionScope&) = delete;
+    ~TimerResolutionScope() {
+        ::timeEndPeriod(1);
+    }
+};
+#endif
+
+std::wstring label(const Worker& worker, std::wstring_view text) {
+    std::wstring composed {text};
+    composed.append(worker.tag);
+    return composed;
 }
 
-PipeClient connect_pipe_with_retry(const std::wstring& pipe_name) {
-    while (true) {
-        try {
-            return PipeClient::connect(pipe_name, GENERIC_WRITE | GENERIC_READ, 0, FILE_ATTRIBUTE_NORMAL);
-        } catch (const std::system_error& ex) {
-            logging::log_system_error(L"Pipe connect failed, retrying", ex);
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
+void log_error(const Worker& worker, std::wstring_view text, DWORD error) {
+    worker.stats.errors.fetch_add(1, std::memory_order_relaxed);
+    logging::log_message(label(worker, text), error);
+}
+
+// Keeps an input that may have made the server disconnect or fail a read.
+void save_fault(const Worker& worker, std::span<const std::byte> input) {
+    if (worker.corpus != nullptr && worker.corpus->add(input)) {
+        worker.stats.saved.fetch_add(1, std::memory_order_relaxed);
+        logging::log_message(label(worker, L"Saved input to corpus"), ERROR_SUCCESS);
     }
 }
 
-bool emit_available_responses(PipeClient& pipe, std::vector<std::byte>& buffer, bool& connection_closed) {
-    connection_closed = false;
+ConnectionManager make_connection_manager(const Worker& worker) {
+    return ConnectionManager(worker.pipe_name, GENERIC_WRITE | GENERIC_READ, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, worker.reconnect,
+        PayloadGenerator::derive_seed(worker.seed, ~0ull), [&worker](const std::system_error& ex) {
+            worker.stats.errors.fetch_add(1, std::memory_order_relaxed);
+            logging::log_system_error(label(worker, L"Pipe connect failed, retrying"), ex);
+        });
+}
+
+bool is_disconnect(DWORD error) {
+    return error == ERROR_BROKEN_PIPE || error == ERROR_PIPE_NOT_CONNECTED || error == ERROR_NO_DATA;
+}
+
+std::wstring sequence_label(const Worker& worker, std::wstring_view text, std::uint64_t sequence) {
+    return label(worker, text) + L" (seq " + std::to_wstring(sequence) + L")";
+}
+
+// Payloads kept in flight per connection while responses are serviced.
+constexpr std::size_t kWriteDepth = 4;
 
-    DWORD available = 0;
-    if (!::PeekNamedPipe(pipe.native_handle(), nullptr, 0, nullptr, &available, nullptr)) {
-        const DWORD error = ::GetLastError();
-        if (error == ERROR_BROKEN_PIPE || error == ERROR_PIPE_NOT_CONNECTED) {
-            log_error(L"Pipe connection closed", error);
-            connection_closed = true;
-            return false;
+// Matches responses to payloads in send order. Windows pipe servers are
+// expected to use message mode, where each complete response message answers
+// the oldest payload still waiting for one. POSIX sockets and FIFOs are byte
+// streams that merge responses into one read. There a read answers every
+// payload waiting when it lands: that may credit a payload early, but a merge
+// can never leave every later response one payload behind.
+//
+// With a corpus, the last kWriteDepth payloads are also copied into slots
+// allocated up front, as any of them may be the one that faults the server.
+class ResponseTracker {
+public:
+    explicit ResponseTracker(const Worker& worker)
+        : worker_(worker) {
+        if (worker.corpus != nullptr) {
+            recent_bytes_.resize(kWriteDepth * worker.max_payload_size);
         }
-        log_error(L"PeekNamedPipe", error);
-        return false;
     }
 
-    while (available > 0) {
-        const std::size_t chunk = std::min<std::size_t>(buffer.size(), static_cast<std::size_t>(available));
-        auto result = pipe.read(std::span<std::byte>{buffer.data(), chunk});
+    void sent(std::uint64_t sequence, std::chrono::steady_clock::time_point intended, std::span<const std::byte> payload) {
+        // A server that never answers must not grow the queue without bound.
+        if (awaiting_.size() == kMaxAwaiting) {
+            awaiting_.pop_front();
+        }
+        awaiting_.push_back({sequence, intended});
+        last_sent_ = sequence;
 
-        const std::size_t bytes = static_cast<std::size_t>(result.bytes_transferred);
-        logging::log_message(L"Pipe response", result.error, std::span<const std::byte>{buffer.data(), bytes});
+        if (!recent_bytes_.empty()) {
+            Recent& slot = recent_[sequence % kWriteDepth];
+            slot = {sequence, std::min(payload.size(), worker_.max_payload_size)};
+            std::copy_n(payload.begin(), slot.size, recent_bytes_.begin() + static_cast<std::ptrdiff_t>((sequence % kWriteDepth) * worker_.max_payload_size));
+        }
+    }
 
-        if (result.error == ERROR_BROKEN_PIPE || result.error == ERROR_PIPE_NOT_CONNECTED) {
-            log_error(L"Pipe connection closed", result.error);
-            connection_closed = true;
-            return false;
+    void received(std::span<const std::byte> data, DWORD error) {
+        const std::uint64_t sequence = awaiting_.empty() ? last_sent_ : awaiting_.front().sequence;
+        if (worker_.capture != nullptr) {
+            worker_.capture->record(CaptureDirection::received, static_cast<std::uint16_t>(worker_.index), error, data);
         }
-        if (result.error != ERROR_SUCCESS && result.error != ERROR_MORE_DATA) {
-            log_error(L"Pipe read error", result.error);
-            return false;
+        worker_.stats.responses.fetch_add(1, std::memory_order_relaxed);
+        worker_.stats.bytes_received.fetch_add(data.size(), std::memory_order_relaxed);
+        logging::log_message(sequence_label(worker_, L"Pipe response", sequence), error, data);
+
+        if (error != ERROR_SUCCESS) {
+            return;
         }
-        if (result.error == ERROR_SUCCESS && bytes == 0) {
-            break;
+        const auto now = std::chrono::steady_clock::now();
+        std::size_t answered = kMessageTransport ? std::min<std::size_t>(awaiting_.size(), 1) : awaiting_.size();
+        for (; answered > 0; --answered) {
+            worker_.stats.latency.record(now - awaiting_.front().intended);
+            awaiting_.pop_front();
         }
+    }
 
-        available = (available > result.bytes_transferred) ? available - result.bytes_transferred : 0;
-        if (available == 0) {
-            if (!::PeekNamedPipe(pipe.native_handle(), nullptr, 0, nullptr, &available, nullptr)) {
-                const DWORD error = ::GetLastError();
-                if (error == ERROR_BROKEN_PIPE || error == ERROR_PIPE_NOT_CONNECTED) {
-                    log_error(L"Pipe connection closed", error);
-                    connection_closed = true;
-                    return false;
-                }
-                log_error(L"PeekNamedPipe", error);
-                return false;
+    // After a fault, saves those of the last kWriteDepth payloads that are
+    // still waiting for a response.
+    void save_unanswered() const {
+        if (awaiting_.empty()) {
+            return;
+        }
+        const std::uint64_t oldest = awaiting_.front().sequence;
+        for (std::size_t index = 0; index < kWriteDepth; ++index) {
+            const Recent& slot = recent_[index];
+            if (slot.size > 0 && slot.sequence >= oldest) {
+                save_fault(worker_, std::span<const std::byte>(recent_bytes_).subspan(index * worker_.max_payload_size, slot.size));
             }
         }
     }
 
-    return true;
-}
+    void reset() {
+        awaiting_.clear();
+        recent_.fill({});
+    }
 
-} // namespace
+private:
+    struct Awaiting {
+        std::uint64_t sequence;
+        std::chrono::steady_clock::time_point intended;
+    };
 
-int fuzz_pipe(const std::wstring& pipe_name, std::size_t max_payload_size) {
-    if (max_payload_size == 0) {
-        std::wcerr << L"Max payload size must be greater than zero.\n";
-        return EXIT_FAILURE;
-    }
+    struct Recent {
+        std::uint64_t sequence {0};
+        // 0 for an empty slot.
+        std::size_t size {0};
+    };
+
+    static constexpr std::size_t kMaxAwaiting = 4096;
+#if defined(_WIN32)
+    static constexpr bool kMessageTransport = true;
+#else
+    static constexpr bool kMessageTransport = false;
+#endif
+
+    const Worker& worker_;
+    std::deque<Awaiting> awaiting_;
+    std::uint64_t last_sent_ {0};
+    // Slot i holds the payload whose sequence is i modulo kWriteDepth.
+    std::array<Recent, kWriteDepth> recent_ {};
+    std::vector<std::byte> recent_bytes_;
+};
 
+void run_connection(const Worker& worker, std::stop_token stop) {
     try {
-        PipeClient pipe = connect_pipe_with_retry(pipe_name);
+        ResponseTracker tracker {worker};
+        ConnectionManager connections = make_connection_manager(worker);
+        std::optional<AsyncPipe> engine;
+        const auto attach = [&](PipeClient pipe) {
+            tracker.reset();
+            engine.reset();
+            if (pipe.is_valid()) {
+                engine.emplace(std::move(pipe), kWriteDepth, worker.max_payload_size,
+                    [&tracker](std::span<const std::byte> data, DWORD error) { tracker.received(data, error); });
+            }
+        };
+        // A deadline that expires without a stop request fails the worker.
+        const auto reconnect = [&] {
+            attach(connections.reconnect(stop));
+            worker.stats.reconnects.store(connections.reconnects(), std::memory_order_relaxed);
+            worker.stats.reconnect_ns.store(static_cast<std::uint64_t>(connections.time_reconnecting().count()), std::memory_order_relaxed);
+            if (!engine && !stop.stop_requested()) {
+                log_error(worker, L"Reconnect deadline exceeded", ERROR_TIMEOUT);
+                worker.stats.failed = true;
+            }
+        };
+        attach(connections.connect(stop));
+        if (!engine && !stop.stop_requested()) {
+            log_error(worker, L"Connect deadline exceeded", ERROR_TIMEOUT);
+            worker.stats.failed = true;
+            return;
+        }
 
-        std::mt19937 rng(static_cast<unsigned int>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
-        std::uniform_int_distribution<std::size_t> size_dist(1, max_payload_size);
-        std::uniform_int_distribution<int> byte_dist(0, 255);
+        PayloadGenerator generator {worker.seed};
+        std::optional<Mutator> mutator;
+        if (worker.corpus != nullptr) {
+            mutator.emplace(*worker.corpus, worker.seed);
+        }
 
-        std::vector<std::byte> payload(max_payload_size);
-        std::vector<std::byte> response(4096);
+        std::vector<std::byte> payload(worker.max_payload_size);
 
-        logging::log_message(L"Fuzzing started", ERROR_SUCCESS);
+        // Responses are serviced while waiting for the next send slot rather
+        // than polled after each write.
+        const bool paced = worker.schedule.paced();
+        auto next_send = std::chrono::steady_clock::now();
+        std::uint64_t sequence = 0;
 
-        while (true) {
-            if (_kbhit()) {
-                _getch();
-                logging::log_message(L"User requested stop", ERROR_SUCCESS);
-                break;
+        while (engine && !stop.stop_requested()) {
+            std::size_t payload_size = 0;
+            if (mutator) {
+                payload_size = mutator->next(payload);
+            } else {
+                payload_size = generator.uniform(1, worker.max_payload_size);
+                generator.fill(std::span<std::byte>{payload.data(), payload_size});
             }
+            const std::span<const std::byte> input {payload.data(), payload_size};
+            const std::uint64_t current = sequence++;
 
-            const std::size_t payload_size = size_dist(rng);
-            for (std::size_t i = 0; i < payload_size; ++i) {
-                payload[i] = static_cast<std::byte>(byte_dist(rng));
-            }
+            logging::log_message(sequence_label(worker, L"Payload", current), ERROR_SUCCESS, input);
 
-            logging::log_message(L"Payload", ERROR_SUCCESS, std::span<const std::byte>{payload.data(), payload_size});
-
-            bool write_complete = false;
-            while (!write_complete) {
-                try {
-                    pipe.write(std::span<const std::byte>{payload.data(), payload_size});
-                    write_complete = true;
-                } catch (const std::system_error& ex) {
-                    const DWORD code = static_cast<DWORD>(ex.code().value());
-                    if (code == ERROR_BROKEN_PIPE || code == ERROR_PIPE_NOT_CONNECTED || code == ERROR_NO_DATA) {
-                        logging::log_system_error(L"Pipe write failed, reconnecting", ex);
-                        pipe = connect_pipe_with_retry(pipe_name);
-                        continue;
-                    }
-                    throw;
+            // Unpaced sends have no schedule, so latency runs from the write.
+            const auto intended = paced ? next_send : std::chrono::steady_clock::now();
+            DWORD status = ERROR_SUCCESS;
+            try {
+                engine->write(input);
+                if (worker.capture != nullptr) {
+                    worker.capture->record(CaptureDirection::sent, static_cast<std::uint16_t>(worker.index), ERROR_SUCCESS, input);
                 }
-            }
+                worker.stats.payloads.fetch_add(1, std::memory_order_relaxed);
+                worker.stats.bytes_sent.fetch_add(payload_size, std::memory_order_relaxed);
+                tracker.sent(current, intended, input);
 
-            bool connection_closed = false;
-            if (!emit_available_responses(pipe, response, connection_closed)) {
-                if (connection_closed) {
-                    pipe = connect_pipe_with_retry(pipe_name);
-                    continue;
+                next_send = paced ? intended + worker.schedule.spacing(payload_size) : std::chrono::steady_clock::now();
+                status = engine->service_until(next_send);
+            } catch (const std::system_error& ex) {
+                if (!is_disconnect(static_cast<DWORD>(ex.code().value()))) {
+                    throw;
                 }
-                return EXIT_FAILURE;
+                worker.stats.errors.fetch_add(1, std::memory_order_relaxed);
+                logging::log_system_error(label(worker, L"Pipe write failed, reconnecting"), ex);
+                // The failed write was never tracked, and earlier payloads may
+                // still be unanswered.
+                tracker.save_unanswered();
+                save_fault(worker, input);
+                reconnect();
+                continue;
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (status == ERROR_SUCCESS) {
+                continue;
+            }
+            tracker.save_unanswered();
+            if (!is_disconnect(status)) {
+                log_error(worker, L"Pipe read error", status);
+                worker.stats.failed = true;
+                return;
+            }
+            log_error(worker, L"Pipe connection closed", status);
+            reconnect();
         }
-
-        return EXIT_SUCCESS;
     } catch (const std::system_error& ex) {
-        logging::log_system_error(L"Fuzzing failed", ex);
-        return EXIT_FAILURE;
+        worker.stats.failed = true;
+        logging::log_system_error(label(worker, L"Fuzzing failed"), ex);
     } catch (const std::exception& ex) {
+        worker.stats.failed = true;
         std::cerr << "Fuzzing failed: " << ex.what() << "\n";
+    }
+}
+
+struct StatsRow {
+    std::uint64_t payloads {0};
+    std::uint64_t bytes_sent {0};
+    std::uint64_t responses {0};
+    std::uint64_t bytes_received {0};
+    std::uint64_t errors {0};
+    std::uint64_t reconnects {0};
+    std::uint64_t reconnect_ns {0};
+    std::uint64_t saved {0};
+
+    static StatsRow load(const ConnectionStats& stats) {
+        return {stats.payloads.load(), stats.bytes_sent.load(), stats.responses.load(), stats.bytes_received.load(),
+            stats.errors.load(), stats.reconnects.load(), stats.reconnect_ns.load(), stats.saved.load()};
+    }
+
+    void merge(const StatsRow& other) {
+        payloads += other.payloads;
+        bytes_sent += other.bytes_sent;
+        responses += other.responses;
+        bytes_received += other.bytes_received;
+        errors += other.errors;
+        reconnects += other.reconnects;
+        reconnect_ns += other.reconnect_ns;
+        saved += other.saved;
+    }
+};
+
+void print_stats_row(std::wstring_view name, const StatsRow& row, double seconds) {
+    std::wcout << std::setw(6) << name << std::setw(11) << row.payloads << std::setw(14) << row.bytes_sent << std::setw(11) << row.responses
+               << std::setw(14) << row.bytes_received << std::setw(8) << row.errors << std::setw(12) << row.reconnects << std::fixed
+               << std::setprecision(1) << std::setw(11) << static_cast<double>(row.reconnect_ns) / 1e6 << std::setw(7) << row.saved
+               << std::setprecision(2) << std::setw(10) << static_cast<double>(row.bytes_sent) / (1024.0 * 1024.0) / seconds << L"\n";
+}
+
+void print_latency_row(std::wstring_view name, const LatencyHistogram& histogram) {
+    const auto milliseconds = [](std::chrono::nanoseconds value) {
+        return std::chrono::duration<double, std::milli>(value).count();
+    };
+    std::wcout << std::setw(6) << name << std::setw(11) << histogram.count() << std::fixed << std::setprecision(3) << std::setw(11)
+               << milliseconds(histogram.mean());
+    for (const double percentile : kReportedPercentiles) {
+        std::wcout << std::setw(11) << milliseconds(histogram.percentile(percentile));
+    }
+    std::wcout << std::setw(11) << milliseconds(histogram.max()) << L"\n";
+}
+
+void print_summary(const std::vector<ConnectionStats>& stats, std::chrono::steady_clock::duration elapsed) {
+    const double seconds = std::max(std::chrono::duration<double>(elapsed).count(), 1e-9);
+
+    std::wcout << std::setw(6) << L"conn" << std::setw(11) << L"payloads" << std::setw(14) << L"bytes sent" << std::setw(11)
+               << L"responses" << std::setw(14) << L"bytes recv" << std::setw(8) << L"errors" << std::setw(12) << L"reconnects"
+               << std::setw(11) << L"reconn ms" << std::setw(7) << L"saved" << std::setw(10) << L"MB/s" << L"\n";
+
+    StatsRow total;
+    for (std::size_t index = 0; index < stats.size(); ++index) {
+        const StatsRow row = StatsRow::load(stats[index]);
+        total.merge(row);
+        if (stats.size() > 1) {
+            print_stats_row(std::to_wstring(index), row, seconds);
+        }
+    }
+    print_stats_row(L"total", total, seconds);
+
+    std::wcout << L"\n" << std::setw(6) << L"conn" << std::setw(11) << L"samples" << std::setw(11) << L"mean ms" << std::setw(11) << L"p50 ms" << std::setw(11)
+               << L"p90 ms" << std::setw(11) << L"p99 ms" << std::setw(11) << L"p99.9 ms" << std::setw(11) << L"max ms" << L"\n";
+    LatencyHistogram merged;
+    for (std::size_t index = 0; index < stats.size(); ++index) {
+        const LatencyHistogram histogram = stats[index].latency.snapshot();
+        merged.merge(histogram);
+        if (stats.size() > 1) {
+            print_latency_row(std::to_wstring(index), histogram);
+        }
+    }
+    print_latency_row(L"total", merged);
+}
+
+LatencyHistogram merge_latency(const std::vector<ConnectionStats>& stats) {
+    LatencyHistogram merged;
+    for (const ConnectionStats& entry : stats) {
+        merged.merge(entry.latency.snapshot());
+    }
+    return merged;
+}
+
+void report_interval_latency(const std::vector<ConnectionStats>& stats, LatencyHistogram& previous, std::chrono::steady_clock::duration interval) {
+    LatencyHistogram current = merge_latency(stats);
+    LatencyHistogram delta = current;
+    delta.subtract(previous);
+    previous = current;
+
+    std::wostringstream text;
+    text.setf(std::ios::fixed);
+    text.precision(1);
+    text << L"Latency over " << std::chrono::duration<double>(interval).count() << L" s: " << delta.count() << L" responses";
+    if (delta.count() > 0) {
+        text << L", " << describe_percentiles(delta);
+    }
+    logging::log_message(text.str(), ERROR_SUCCESS);
+}
+
+} // namespace
+
+int fuzz_pipe(const std::wstring& pipe_name, const FuzzOptions& options) {
+    if (options.max_payload_size == 0) {
+        std::wcerr << L"Max payload size must be greater than zero.\n";
         return EXIT_FAILURE;
     }
+    if (options.connections == 0) {
+        std::wcerr << L"Connection count must be greater than zero.\n";
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<Corpus> corpus;
+    std::size_t max_payload_size = options.max_payload_size;
+    if (!options.corpus_directory.empty()) {
+        try {
+            corpus = std::make_unique<Corpus>(options.corpus_directory);
+        } catch (const std::system_error& ex) {
+            logging::log_system_error(L"Corpus load failed", ex);
+            return EXIT_FAILURE;
+        } catch (const std::exception& ex) {
+            std::cerr << "Corpus load failed: " << ex.what() << "\n";
+            return EXIT_FAILURE;
+        }
+        max_payload_size = std::max(max_payload_size, corpus->largest());
+        logging::log_message(L"Loaded " + std::to_wstring(corpus->size()) + L" corpus entries", ERROR_SUCCESS);
+    }
+
+    std::unique_ptr<CaptureWriter> capture;
+    if (!options.record_path.empty()) {
+        if (options.connections > 0x10000) {
+            std::wcerr << L"A capture can hold at most 65536 connections.\n";
+            return EXIT_FAILURE;
+        }
+        try {
+            capture = std::make_unique<CaptureWriter>(options.record_path);
+        } catch (const std::exception& ex) {
+            std::cerr << "Capture failed: " << ex.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    install_stop_handler();
+
+    std::vector<ConnectionStats> stats(options.connections);
+    std::stop_source stop;
+    std::atomic<std::size_t> active {options.connections};
+
+    SendSchedule schedule;
+    if (options.rate != 0) {
+        schedule.per_message = std::chrono::duration<double>(1.0 / static_cast<double>(options.rate));
+    }
+    if (options.bytes_per_second != 0) {
+        schedule.per_byte = std::chrono::duration<double>(1.0 / static_cast<double>(options.bytes_per_second));
+    }
+#if defined(_WIN32)
+    const TimerResolutionScope timer_resolution;
+#endif
+
+    const std::uint64_t seed = options.seed.value_or(
+        static_cast<std::uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+    logging::log_message(L"Fuzzing started (seed " + std::to_wstring(seed) + L")", ERROR_SUCCESS);
+    const auto started = std::chrono::steady_clock::now();
+
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(options.connections);
+        for (std::size_t index = 0; index < options.connections; ++index) {
+            workers.emplace_back([&, index] {
+                const Worker worker {
+                    pipe_name,
+                    max_payload_size,
+                    index,
+                    PayloadGenerator::derive_seed(seed, index),
+                    schedule,
+                    options.reconnect,
+                    options.connections > 1 ? L" #" + std::to_wstring(index) : std::wstring {},
+                    stats[index],
+                    corpus.get(),
+                    capture.get()};
+                run_connection(worker, stop.get_token());
+                active.fetch_sub(1);
+            });
+        }
+
+        // Interval reports diff against the merged counts at the previous report.
+        auto previous_latency = std::make_unique<LatencyHistogram>();
+        auto last_report = started;
+        while (active.load() > 0) {
+            if (user_requested_stop()) {
+                logging::log_message(L"User requested stop", ERROR_SUCCESS);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            const auto now = std::chrono::steady_clock::now();
+            if (options.report_interval.count() > 0 && now - last_report >= options.report_interval) {
+                report_interval_latency(stats, *previous_latency, now - last_report);
+                last_report = now;
+            }
+        }
+        stop.request_stop();
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+    if (capture) {
+        try {
+            capture->flush();
+        } catch (const std::exception& ex) {
+            std::cerr << "Capture failed: " << ex.what() << "\n";
+        }
+    }
+    logging::flush();
+    print_summary(stats, elapsed);
+
+    const bool failed = std::any_of(stats.begin(), stats.end(), [](const ConnectionStats& entry) { return entry.failed.load(); });
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 } // namespace pipetool
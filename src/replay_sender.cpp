@@ -0,0 +1,199 @@
+#include "pipetool/replay_sender.hpp"
+
+#include "pipetool/capture.hpp"
+#include "pipetool/logging.hpp"
+#include "pipetool/message_reader.hpp"
+#include "pipetool/pipe_client.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "pipetool/platform.hpp"
+
+namespace pipetool {
+namespace {
+
+struct ReplayTotals {
+    std::uint64_t payloads {0};
+    std::uint64_t bytes_sent {0};
+    std::uint64_t bytes_received {0};
+    std::uint64_t reconnects {0};
+};
+
+PipeClient connect_pipe(const std::wstring& pipe_name) {
+    return PipeClient::connect(pipe_name, GENERIC_WRITE | GENERIC_READ, 0, FILE_ATTRIBUTE_NORMAL);
+}
+
+// Reads whatever the server has already sent so it never blocks on a full pipe.
+std::uint64_t drain_available(const PipeClient& pipe, std::span<std::byte> buffer, ResponseMatcher* matcher) {
+    std::uint64_t received = 0;
+    while (true) {
+        const auto peeked = pipe.peek();
+        if (peeked.error != ERROR_SUCCESS || peeked.bytes_transferred == 0) {
+            return received;
+        }
+        const std::size_t chunk = std::min<std::size_t>(buffer.size(), peeked.bytes_transferred);
+        const auto result = pipe.read(buffer.first(chunk));
+        received += result.bytes_transferred;
+        if (matcher != nullptr) {
+            matcher->received(buffer.first(result.bytes_transferred));
+        }
+        if (result.error != ERROR_SUCCESS && result.error != ERROR_MORE_DATA) {
+            return received;
+        }
+    }
+}
+
+// Reads until the server closes the connection, so that a golden comparison
+// sees the whole response.
+std::uint64_t drain_until_closed(const PipeClient& pipe, ResponseMatcher& matcher) {
+    std::uint64_t received = 0;
+    MessageReader reader {pipe};
+    while (true) {
+        const auto message = reader.next();
+        if (message.error != ERROR_SUCCESS || message.data.empty()) {
+            return received;
+        }
+        matcher.received(message.data);
+        received += message.data.size();
+    }
+}
+
+// Connections answer in no fixed order relative to each other, so only a
+// single-connection capture yields a response stream a golden file can match.
+bool has_several_connections(const std::filesystem::path& capture_path) {
+    CaptureReader reader {capture_path};
+    CaptureRecord record;
+    while (reader.next(record)) {
+        if (record.connection != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Recorded sessions may include the server dropping the connection, so a
+// disconnect is answered with one reconnect and a retry of the same payload.
+void send_record(const std::wstring& pipe_name, PipeClient& pipe, std::span<const std::byte> payload, ReplayTotals& totals) {
+    try {
+        pipe.write(payload);
+    } catch (const std::system_error& ex) {
+        const DWORD code = static_cast<DWORD>(ex.code().value());
+        if (code != ERROR_BROKEN_PIPE && code != ERROR_PIPE_NOT_CONNECTED && code != ERROR_NO_DATA) {
+            throw;
+        }
+        logging::log_system_error(L"Pipe write failed, reconnecting", ex);
+        pipe = connect_pipe(pipe_name);
+        ++totals.reconnects;
+        pipe.write(payload);
+    }
+}
+
+std::wstring describe_replay(const ReplayTotals& totals, std::chrono::steady_clock::duration elapsed) {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    const double megabytes = static_cast<double>(totals.bytes_sent) / (1024.0 * 1024.0);
+
+    std::wostringstream label;
+    label.setf(std::ios::fixed);
+    label.precision(1);
+    label << L"Replayed " << totals.payloads << L" payloads (" << totals.bytes_sent << L" bytes) in " << seconds * 1000.0 << L" ms";
+    if (seconds > 0.0) {
+        label << L" (" << megabytes / seconds << L" MB/s)";
+    }
+    label << L", " << totals.bytes_received << L" bytes received, " << totals.reconnects << L" reconnects";
+    return label.str();
+}
+
+} // namespace
+
+int replay_capture(const std::wstring& pipe_name, const std::filesystem::path& capture_path, const ReplayOptions& options) {
+    try {
+        std::optional<CaptureReader> reader;
+        try {
+            reader.emplace(capture_path);
+        } catch (const std::system_error& ex) {
+            std::wcerr << L"Unable to open capture: " << capture_path.wstring() << L"\n";
+            logging::log_system_error(L"Open failed", ex);
+            return EXIT_FAILURE;
+        }
+
+        if (!options.expect.path.empty() && has_several_connections(capture_path)) {
+            std::wcerr << L"--expect needs a capture of a single connection.\n";
+            return EXIT_FAILURE;
+        }
+        std::optional<ResponseMatcher> matcher;
+        if (!open_expected(options.expect, matcher)) {
+            return EXIT_FAILURE;
+        }
+        ResponseMatcher* const checked = matcher ? &*matcher : nullptr;
+
+        std::vector<PipeClient> pipes;
+        std::array<std::byte, 4096> response_buffer {};
+        ReplayTotals totals;
+
+        const auto started = std::chrono::steady_clock::now();
+        std::optional<std::chrono::nanoseconds> first_timestamp;
+
+        CaptureRecord record;
+        while (reader->next(record)) {
+            if (record.direction != CaptureDirection::sent) {
+                continue;
+            }
+
+            if (options.paced) {
+                if (!first_timestamp) {
+                    first_timestamp = record.timestamp;
+                }
+                std::this_thread::sleep_until(started + (record.timestamp - *first_timestamp));
+            }
+
+            if (record.connection >= pipes.size()) {
+                pipes.resize(static_cast<std::size_t>(record.connection) + 1);
+            }
+            PipeClient& pipe = pipes[record.connection];
+            if (!pipe.is_valid()) {
+                pipe = connect_pipe(pipe_name);
+            }
+
+            send_record(pipe_name, pipe, record.payload, totals);
+            ++totals.payloads;
+            totals.bytes_sent += record.payload.size();
+            totals.bytes_received += drain_available(pipe, response_buffer, checked);
+        }
+
+        for (const PipeClient& pipe : pipes) {
+            if (!pipe.is_valid()) {
+                continue;
+            }
+            if (const DWORD error = pipe.flush(); error != ERROR_SUCCESS) {
+                logging::log_message(L"FlushFileBuffers", error);
+            }
+            totals.bytes_received += checked != nullptr ? drain_until_closed(pipe, *checked) : drain_available(pipe, response_buffer, nullptr);
+        }
+
+        logging::log_message(describe_replay(totals, std::chrono::steady_clock::now() - started), ERROR_SUCCESS);
+        if (matcher && !matcher->finish()) {
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    } catch (const std::system_error& ex) {
+        logging::log_system_error(L"Replay failed", ex);
+        return EXIT_FAILURE;
+    } catch (const std::exception& ex) {
+        std::cerr << "Replay failed: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
+
+} // namespace pipetool
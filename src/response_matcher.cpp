@@ -0,0 +1,168 @@
+#include "pipetool/response_matcher.hpp"
+
+#include "pipetool/logging.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "pipetool/platform.hpp"
+
+namespace pipetool {
+namespace {
+
+// Bytes shown on either side of a divergence.
+constexpr std::size_t kContextBefore = 16;
+constexpr std::size_t kContextAfter = 32;
+
+// The golden file is faulted in and released in steps of this many bytes,
+// so residency stays bounded however long the stream.
+constexpr std::uint64_t kResidentWindow = 4 * 1024 * 1024;
+
+std::vector<MaskRange> normalize_masks(std::vector<MaskRange> masks, std::uint64_t size) {
+    std::ranges::sort(masks, {}, &MaskRange::offset);
+    std::vector<MaskRange> merged;
+    for (const MaskRange& mask : masks) {
+        const std::uint64_t begin = std::min(mask.offset, size);
+        const std::uint64_t end = mask.length > size - begin ? size : begin + mask.length;
+        if (begin == end) {
+            continue;
+        }
+        if (!merged.empty() && begin <= merged.back().offset + merged.back().length) {
+            merged.back().length = std::max(merged.back().offset + merged.back().length, end) - merged.back().offset;
+        } else {
+            merged.push_back({begin, end - begin});
+        }
+    }
+    return merged;
+}
+
+} // namespace
+
+ResponseMatcher::ResponseMatcher(const ExpectOptions& options)
+    : path_(options.path),
+      expected_(MappedFile::open(options.path)),
+      masks_(normalize_masks(options.masks, expected_.bytes().size())) {
+    const auto expected = expected_.bytes();
+    expected_.prefetch(expected.first(static_cast<std::size_t>(std::min<std::uint64_t>(kResidentWindow, expected.size()))));
+}
+
+void ResponseMatcher::received(std::span<const std::byte> bytes) {
+    if (divergence_) {
+        position_ += bytes.size();
+        return;
+    }
+    compare(bytes);
+    remember(bytes);
+    position_ += bytes.size();
+
+    const auto expected = expected_.bytes();
+    if (position_ >= resident_ + kResidentWindow && resident_ < expected.size()) {
+        const std::uint64_t done = std::min<std::uint64_t>(position_, expected.size());
+        expected_.release(expected.subspan(resident_, done - resident_));
+        resident_ = done;
+        expected_.prefetch(expected.subspan(resident_, std::min<std::uint64_t>(kResidentWindow, expected.size() - resident_)));
+    }
+}
+
+// Compares each unmasked run with one memcmp, which the C library vectorises,
+// and only looks for the exact byte once a run is known to differ.
+void ResponseMatcher::compare(std::span<const std::byte> bytes) {
+    const auto expected = expected_.bytes();
+    const std::uint64_t start = position_;
+    const std::uint64_t limit = std::min<std::uint64_t>(start + bytes.size(), expected.size());
+
+    auto mask = std::ranges::find_if(masks_, [start](const MaskRange& range) { return range.offset + range.length > start; });
+    std::uint64_t cursor = start;
+    while (cursor < limit) {
+        if (mask != masks_.end() && mask->offset <= cursor) {
+            cursor = std::min(limit, mask->offset + mask->length);
+            ++mask;
+            continue;
+        }
+        const std::uint64_t stop = mask != masks_.end() ? std::min(limit, mask->offset) : limit;
+        const std::byte* actual = bytes.data() + (cursor - start);
+        const std::byte* wanted = expected.data() + cursor;
+        const auto length = static_cast<std::size_t>(stop - cursor);
+        if (std::memcmp(actual, wanted, length) != 0) {
+            const auto first = std::mismatch(actual, actual + length, wanted).first;
+            report(bytes, static_cast<std::size_t>(first - bytes.data()));
+            return;
+        }
+        cursor = stop;
+    }
+    if (start + bytes.size() > expected.size()) {
+        report(bytes, static_cast<std::size_t>(expected.size() - start));
+    }
+}
+
+void ResponseMatcher::report(std::span<const std::byte> bytes, std::size_t index) {
+    const auto expected = expected_.bytes();
+    const std::uint64_t offset = position_ + index;
+    const std::uint64_t from = offset - std::min<std::uint64_t>(kContextBefore, offset);
+    divergence_ = offset;
+
+    if (offset >= expected.size()) {
+        logging::log_message(L"Response continues past the " + std::to_wstring(expected.size()) + L" bytes of " + path_.wstring(), ERROR_CRC);
+    } else {
+        logging::log_message(L"Response diverges from " + path_.wstring() + L" at offset " + std::to_wstring(offset), ERROR_CRC);
+    }
+
+    const std::uint64_t expected_end = std::min<std::uint64_t>(offset + kContextAfter, expected.size());
+    const auto wanted = expected.subspan(static_cast<std::size_t>(std::min<std::uint64_t>(from, expected.size())),
+                                         static_cast<std::size_t>(expected_end > from ? expected_end - from : 0));
+    logging::log_message(L"Expected from offset " + std::to_wstring(from), ERROR_SUCCESS, wanted);
+
+    // The bytes before the divergence may straddle earlier reads.
+    std::vector<std::byte> actual(history_);
+    const std::size_t after = std::min(bytes.size(), index + kContextAfter);
+    actual.insert(actual.end(), bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(after));
+    const auto shown = static_cast<std::size_t>(offset - from) + (after - index);
+    logging::log_message(L"Received from offset " + std::to_wstring(from), ERROR_SUCCESS, std::span<const std::byte>(actual).last(shown));
+}
+
+void ResponseMatcher::remember(std::span<const std::byte> bytes) {
+    history_.insert(history_.end(), bytes.end() - static_cast<std::ptrdiff_t>(std::min(bytes.size(), kContextBefore)), bytes.end());
+    if (history_.size() > kContextBefore) {
+        history_.erase(history_.begin(), history_.end() - static_cast<std::ptrdiff_t>(kContextBefore));
+    }
+}
+
+bool ResponseMatcher::finish() {
+    const auto expected = expected_.bytes();
+    if (!divergence_ && position_ < expected.size()) {
+        divergence_ = position_;
+        logging::log_message(L"Response ended after " + std::to_wstring(position_) + L" of the " + std::to_wstring(expected.size()) + L" bytes of " + path_.wstring(), ERROR_CRC);
+        const auto missing = expected.subspan(static_cast<std::size_t>(position_));
+        logging::log_message(L"Expected from offset " + std::to_wstring(position_), ERROR_SUCCESS, missing.first(std::min(missing.size(), kContextAfter)));
+    }
+    if (divergence_) {
+        return false;
+    }
+
+    std::uint64_t masked = 0;
+    for (const MaskRange& mask : masks_) {
+        masked += mask.length;
+    }
+    logging::log_message(L"Response matches " + path_.wstring() + L": " + std::to_wstring(position_) + L" bytes, " + std::to_wstring(masked) + L" masked", ERROR_SUCCESS);
+    return true;
+}
+
+bool open_expected(const ExpectOptions& options, std::optional<ResponseMatcher>& matcher) {
+    if (options.path.empty()) {
+        return true;
+    }
+    try {
+        matcher.emplace(options);
+    } catch (const std::system_error& ex) {
+        std::wcerr << L"Unable to open expected output: " << options.path.wstring() << L"\n";
+        logging::log_system_error(L"Open failed", ex);
+        return false;
+    }
+    return true;
+}
+
+} // namespace pipetool
@@ -0,0 +1,78 @@
+#include "pipetool/serve.hpp"
+
+#include "pipetool/logging.hpp"
+#include "pipetool/pipe_client.hpp"
+#include "pipetool/stop_request.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "pipetool/platform.hpp"
+
+namespace pipetool {
+namespace {
+
+// How often the stop request is polled between completions.
+constexpr std::chrono::milliseconds kPollInterval {50};
+
+void print_row(std::wstring_view name, const InstanceStats& row, double seconds) {
+    const double megabytes = static_cast<double>(row.bytes_received + row.bytes_sent) / (1024.0 * 1024.0);
+    std::wcout << std::setw(9) << name << std::setw(9) << row.connections << std::setw(11) << row.messages << std::setw(14) << row.bytes_received
+               << std::setw(14) << row.bytes_sent << std::fixed << std::setprecision(2) << std::setw(10) << megabytes / seconds << L"\n";
+}
+
+void print_summary(const std::vector<InstanceStats>& stats, std::chrono::steady_clock::duration elapsed) {
+    const double seconds = std::max(std::chrono::duration<double>(elapsed).count(), 1e-9);
+
+    std::wcout << std::setw(9) << L"instance" << std::setw(9) << L"clients" << std::setw(11) << L"messages" << std::setw(14) << L"bytes recv"
+               << std::setw(14) << L"bytes sent" << std::setw(10) << L"MB/s" << L"\n";
+
+    InstanceStats total;
+    for (std::size_t index = 0; index < stats.size(); ++index) {
+        const InstanceStats& row = stats[index];
+        total.connections += row.connections;
+        total.messages += row.messages;
+        total.bytes_received += row.bytes_received;
+        total.bytes_sent += row.bytes_sent;
+        if (stats.size() > 1) {
+            print_row(std::to_wstring(index), row, seconds);
+        }
+    }
+    print_row(L"total", total, seconds);
+}
+
+} // namespace
+
+int serve_pipe(const std::wstring& pipe_name, const ServeOptions& options) {
+    try {
+        PipeServer server {pipe_name, options};
+        install_stop_handler();
+        logging::log_message(L"Serving " + qualify_pipe_name(pipe_name) + L" with " + std::to_wstring(options.instances) + L" instances",
+            ERROR_SUCCESS);
+
+        const auto started = std::chrono::steady_clock::now();
+        while (!user_requested_stop()) {
+            server.run_for(kPollInterval);
+        }
+        logging::log_message(L"User requested stop", ERROR_SUCCESS);
+
+        logging::flush();
+        print_summary(server.stats(), std::chrono::steady_clock::now() - started);
+        return EXIT_SUCCESS;
+    } catch (const std::system_error& ex) {
+        logging::log_system_error(L"Serve failed", ex);
+        return EXIT_FAILURE;
+    } catch (const std::exception& ex) {
+        std::cerr << "Serve failed: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+}
+
+} // namespace pipetool
@@ -0,0 +1,168 @@
+#include "pipetool/sid_cache.hpp"
+
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace pipetool {
+namespace {
+
+// wchar_t is UTF-16 on Windows and UTF-32 elsewhere; both round-trip here.
+std::string to_utf8(std::wstring_view text) {
+    std::string out;
+    out.reserve(text.size());
+    for (std::size_t index = 0; index < text.size(); ++index) {
+        auto code = static_cast<std::uint32_t>(text[index]);
+        if constexpr (sizeof(wchar_t) == 2) {
+            if (code >= 0xD800 && code < 0xDC00 && index + 1 < text.size()) {
+                const auto low = static_cast<std::uint32_t>(text[index + 1]);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    ++index;
+                }
+            }
+        }
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+    return out;
+}
+
+// Returns nullopt for malformed input, which load() skips.
+std::optional<std::wstring> from_utf8(std::string_view text) {
+    std::wstring out;
+    out.reserve(text.size());
+    for (std::size_t index = 0; index < text.size();) {
+        const auto lead = static_cast<unsigned char>(text[index]);
+        const std::size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+        if (length == 0 || index + length > text.size()) {
+            return std::nullopt;
+        }
+        std::uint32_t code = length == 1 ? lead : lead & (0x7F >> length);
+        for (std::size_t offset = 1; offset < length; ++offset) {
+            const auto next = static_cast<unsigned char>(text[index + offset]);
+            if ((next & 0xC0) != 0x80) {
+                return std::nullopt;
+            }
+            code = (code << 6) | (next & 0x3F);
+        }
+        index += length;
+        if (sizeof(wchar_t) == 2 && code >= 0x10000) {
+            code -= 0x10000;
+            out.push_back(static_cast<wchar_t>(0xD800 + (code >> 10)));
+            out.push_back(static_cast<wchar_t>(0xDC00 + (code & 0x3FF)));
+        } else {
+            out.push_back(static_cast<wchar_t>(code));
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+std::optional<std::wstring> SidNameCache::resolve(const std::wstring& sid, const Lookup& lookup) {
+    std::promise<std::optional<std::wstring>> promise;
+    {
+        std::unique_lock lock(mutex_);
+        if (const auto found = entries_.find(sid); found != entries_.end()) {
+            ++hits_;
+            const Entry entry = found->second;
+            lock.unlock();
+            return entry.get();
+        }
+        ++misses_;
+        entries_.emplace(sid, promise.get_future().share());
+    }
+
+    // The lookup runs unlocked, so a slow SID only holds up callers asking for it.
+    try {
+        std::optional<std::wstring> name = lookup();
+        promise.set_value(name);
+        return name;
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+bool SidNameCache::load(const std::filesystem::path& path) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        return false;
+    }
+
+    std::string line;
+    std::scoped_lock lock(mutex_);
+    while (std::getline(stream, line)) {
+        const std::size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;
+        }
+        auto sid = from_utf8(std::string_view(line).substr(0, tab));
+        auto name = from_utf8(std::string_view(line).substr(tab + 1));
+        if (!sid || !name) {
+            continue;
+        }
+        std::promise<std::optional<std::wstring>> promise;
+        promise.set_value(std::move(*name));
+        entries_.try_emplace(std::move(*sid), promise.get_future().share());
+    }
+    return true;
+}
+
+void SidNameCache::save(const std::filesystem::path& path) const {
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw std::runtime_error("unable to create SID cache " + path.string());
+    }
+
+    std::scoped_lock lock(mutex_);
+    for (const auto& [sid, entry] : entries_) {
+        // Lookups still in flight, failed or unresolved are not worth keeping.
+        if (entry.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            continue;
+        }
+        try {
+            if (const auto& name = entry.get()) {
+                stream << to_utf8(sid) << '\t' << to_utf8(*name) << '\n';
+            }
+        } catch (const std::exception&) {
+        }
+    }
+    if (!stream.flush()) {
+        throw std::runtime_error("unable to write SID cache " + path.string());
+    }
+}
+
+std::uint64_t SidNameCache::hits() const {
+    std::scoped_lock lock(mutex_);
+    return hits_;
+}
+
+std::uint64_t SidNameCache::misses() const {
+    std::scoped_lock lock(mutex_);
+    return misses_;
+}
+
+SidNameCache& SidNameCache::shared() {
+    static SidNameCache cache;
+    return cache;
+}
+
+} // namespace pipetool
@@ -0,0 +1,41 @@
+#include "pipetool/stop_request.hpp"
+
+#if defined(_WIN32)
+#include <conio.h>
+#else
+#include <csignal>
+#endif
+
+namespace pipetool {
+namespace {
+
+#if !defined(_WIN32)
+volatile std::sig_atomic_t interrupted = 0;
+
+void on_interrupt(int) {
+    interrupted = 1;
+}
+#endif
+
+} // namespace
+
+void install_stop_handler() {
+#if !defined(_WIN32)
+    interrupted = 0;
+    std::signal(SIGINT, on_interrupt);
+#endif
+}
+
+bool user_requested_stop() {
+#if defined(_WIN32)
+    if (_kbhit()) {
+        _getch();
+        return true;
+    }
+    return false;
+#else
+    return interrupted != 0;
+#endif
+}
+
+} // namespace pipetool
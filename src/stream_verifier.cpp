@@ -0,0 +1,110 @@
+#include "pipetool/stream_verifier.hpp"
+
+#include "pipetool/checksum.hpp"
+#include "pipetool/logging.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "pipetool/platform.hpp"
+
+namespace pipetool {
+namespace {
+
+// Mismatches past this many are counted but not logged one by one.
+constexpr std::uint64_t kMaxLoggedMismatches = 16;
+
+void log_mismatch(std::uint64_t first, std::uint64_t last, std::uint32_t sent, std::uint32_t received) {
+    std::wostringstream label;
+    label << L"Echo mismatch in bytes " << first << L"-" << last << std::hex << std::setfill(L'0')
+          << L" (crc32c sent 0x" << std::setw(8) << sent << L", received 0x" << std::setw(8) << received << L")";
+    logging::log_message(label.str(), ERROR_CRC);
+}
+
+} // namespace
+
+StreamVerifier::StreamVerifier(std::size_t block_size)
+    : block_size_(block_size) {
+    if (block_size == 0) {
+        throw std::invalid_argument("block size must be greater than zero");
+    }
+}
+
+void StreamVerifier::sent(std::span<const std::byte> bytes) {
+    append(sent_, bytes);
+}
+
+void StreamVerifier::received(std::span<const std::byte> bytes) {
+    append(received_, bytes);
+}
+
+// Checksums outside the lock, which is taken once per call rather than once
+// per block.
+void StreamVerifier::append(Side& side, std::span<const std::byte> bytes) {
+    side.total += bytes.size();
+    while (!bytes.empty()) {
+        const std::size_t take = std::min(block_size_ - side.fill, bytes.size());
+        side.crc = crc32c(bytes.first(take), side.crc);
+        side.fill += take;
+        bytes = bytes.subspan(take);
+        if (side.fill == block_size_) {
+            side.completed.push_back(side.crc);
+            side.crc = 0;
+            side.fill = 0;
+        }
+    }
+    if (side.completed.empty()) {
+        return;
+    }
+
+    const std::lock_guard lock {mutex_};
+    side.blocks.insert(side.blocks.end(), side.completed.begin(), side.completed.end());
+    side.completed.clear();
+    compare_locked();
+}
+
+void StreamVerifier::compare_locked(std::uint64_t end) {
+    while (!sent_.blocks.empty() && !received_.blocks.empty()) {
+        const std::uint32_t sent = sent_.blocks.front();
+        const std::uint32_t received = received_.blocks.front();
+        sent_.blocks.pop_front();
+        received_.blocks.pop_front();
+
+        if (sent != received && ++mismatches_ <= kMaxLoggedMismatches) {
+            const std::uint64_t first = compared_ * block_size_;
+            log_mismatch(first, std::min<std::uint64_t>(first + block_size_, end) - 1, sent, received);
+        }
+        ++compared_;
+    }
+}
+
+bool StreamVerifier::finish() {
+    const std::lock_guard lock {mutex_};
+    for (Side* side : {&sent_, &received_}) {
+        if (side->fill > 0) {
+            side->blocks.push_back(side->crc);
+            side->fill = 0;
+        }
+    }
+    const std::uint64_t sent_total = sent_.total;
+    const std::uint64_t received_total = received_.total;
+    compare_locked(std::max(sent_total, received_total));
+
+    bool matched = mismatches_ == 0;
+    if (sent_total != received_total) {
+        matched = false;
+        logging::log_message(L"Echo length mismatch: sent " + std::to_wstring(sent_total) + L" bytes, received " + std::to_wstring(received_total), ERROR_CRC);
+    }
+
+    if (matched) {
+        logging::log_message(L"Echo verified: " + std::to_wstring(sent_total) + L" bytes (crc32c)", ERROR_SUCCESS);
+    } else {
+        logging::log_message(L"Echo verification failed: " + std::to_wstring(mismatches_) + L" of " + std::to_wstring(compared_) + L" blocks differ", ERROR_CRC);
+    }
+    return matched;
+}
+
+} // namespace pipetool